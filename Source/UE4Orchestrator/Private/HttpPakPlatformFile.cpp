@@ -0,0 +1,662 @@
+/* -*- mode: c; tab-width: 4; indent-tabs-mode: nil; -*- */
+
+/*
+ *  UE4Orchestrator.h acts as the PCH for this project and must be the
+ *  very first file imported.
+ */
+#include "UE4Orchestrator.h"
+
+#include "HttpPakPlatformFile.h"
+
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+const int64 FHttpPakPlatformFile::BlockSize = 1024 * 1024;
+
+// Default size of the shared block cache.
+static const int64 DEFAULT_CACHE_LIMIT = 64LL * 1024 * 1024 * 1024;
+
+// Number of times a block is requested before a read fails.
+static const int   BLOCK_FETCH_ATTEMPTS = 3;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// How long a single request may take before it is abandoned.
+static const double HTTP_TIMEOUT_S = 10.0;
+
+// Largest response header accepted.
+static const int64 HTTP_MAX_HEADER = 16 * 1024;
+
+/*
+ *  A parsed HTTP response.  `RangeFirst` and `RangeLast` are the inclusive
+ *  byte range from the Content-Range header, or -1 without one.
+ */
+struct FHttpResponse
+{
+    int           Status        = -1;
+    int64         ContentLength = -1;
+    int64         RangeFirst    = -1;
+    int64         RangeLast     = -1;
+    FString       ETag;
+    FString       LastModified;
+    TArray<uint8> Body;
+};
+
+/*
+ *  Wait for `sock` to become ready, giving up at `deadline`.
+ */
+static bool
+wait_socket(FSocket* sock, ESocketWaitConditions::Type cond, double deadline)
+{
+    double left = deadline - FPlatformTime::Seconds();
+    return left > 0.0 && sock->Wait(cond, FTimespan::FromSeconds(left));
+}
+
+/*
+ *  Issue a single HTTP/1.1 request and read the whole response.  A `len` of
+ *  zero requests the whole resource, otherwise the byte range starting at
+ *  `offset` is requested.  The socket is non-blocking and the request is
+ *  abandoned after HTTP_TIMEOUT_S, so a stalled server cannot hang the
+ *  caller, and responses larger than what was asked for are rejected.
+ *  Returns false if the server could not be talked to.
+ */
+static bool
+http_request(const FHttpPak& pak, const char* method, int64 offset, int64 len, FHttpResponse& rsp)
+{
+    ISocketSubsystem* sockets = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    TSharedRef<FInternetAddr> addr = sockets->CreateInternetAddr();
+
+    if (sockets->GetHostByName(TCHAR_TO_ANSI(*pak.Host), *addr) != SE_NO_ERROR)
+        return false;
+    addr->SetPort(pak.Port);
+
+    FSocket* sock = sockets->CreateSocket(NAME_Stream, T("UE4Orc HTTP pak"), false);
+    if (sock == nullptr)
+        return false;
+
+    double        deadline = FPlatformTime::Seconds() + HTTP_TIMEOUT_S;
+    int64         limit    = HTTP_MAX_HEADER + (len > 0 ? len : 0);
+    bool          ok       = false;
+    TArray<uint8> raw;
+
+    sock->SetNonBlocking(true);
+    if (sock->Connect(*addr) &&
+        wait_socket(sock, ESocketWaitConditions::WaitForWrite, deadline) &&
+        sock->GetConnectionState() == SCS_Connected)
+    {
+        FString req = FString::Printf(T("%s %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n"),
+                                      ANSI_TO_TCHAR(method), *pak.Path, *pak.Host);
+        if (len > 0)
+            req += FString::Printf(T("Range: bytes=%lld-%lld\r\n"), offset, offset + len - 1);
+
+        // A pak changed on the server is sent whole, which is then rejected
+        if (len > 0 && pak.Validator.Len() > 0 && !pak.Validator.StartsWith(T("W/")))
+            req += FString::Printf(T("If-Range: %s\r\n"), *pak.Validator);
+        req += T("\r\n");
+
+        FTCHARToUTF8 utf8(*req);
+        int32 total = 0;
+        while (total < utf8.Length())
+        {
+            int32 sent = 0;
+            if (!wait_socket(sock, ESocketWaitConditions::WaitForWrite, deadline) ||
+                !sock->Send((const uint8*)utf8.Get() + total, utf8.Length() - total, sent))
+                break;
+            total += sent;
+        }
+
+        if (total == utf8.Length())
+        {
+            uint8 buf[64 * 1024];
+            int32 read = 0;
+
+            raw.Reserve(FMath::Min(limit, (int64)(len + sizeof(buf))));
+            for (;;)
+            {
+                if (!wait_socket(sock, ESocketWaitConditions::WaitForRead, deadline))
+                {
+                    LOG("%s %s timed out", ANSI_TO_TCHAR(method), *pak.Url);
+                    break;
+                }
+
+                // Recv fails once the server has closed the connection
+                if (!sock->Recv(buf, sizeof(buf), read))
+                {
+                    ok = true;
+                    break;
+                }
+
+                if (raw.Num() + read > limit)
+                {
+                    LOG("%s %s returned more than the %lld bytes expected", ANSI_TO_TCHAR(method), *pak.Url, limit);
+                    break;
+                }
+                raw.Append(buf, read);
+            }
+        }
+    }
+
+    sock->Close();
+    sockets->DestroySocket(sock);
+
+    if (!ok)
+        return false;
+
+    // Split the response into its header and body
+    int32 header = -1;
+    for (int32 i = 0; i + 3 < raw.Num(); i++)
+    {
+        if (raw[i] == '\r' && raw[i + 1] == '\n' && raw[i + 2] == '\r' && raw[i + 3] == '\n')
+        {
+            header = i + 4;
+            break;
+        }
+    }
+    if (header < 0)
+        return false;
+
+    FString head;
+    for (int32 i = 0; i < header; i++)
+        head.AppendChar((TCHAR)raw[i]);
+
+    TArray<FString> lines;
+    head.ParseIntoArrayLines(lines);
+    if (lines.Num() == 0)
+        return false;
+
+    FString code;
+    lines[0].Split(T(" "), nullptr, &code);
+    rsp.Status = FCString::Atoi(*code);
+
+    for (auto& line : lines)
+    {
+        FString key, value;
+        if (!line.Split(T(":"), &key, &value))
+            continue;
+
+        key   = key.TrimStartAndEnd();
+        value = value.TrimStartAndEnd();
+        if (key == T("Content-Length"))
+        {
+            rsp.ContentLength = FCString::Atoi64(*value);
+        }
+        else if (key == T("ETag"))
+        {
+            rsp.ETag = value;
+        }
+        else if (key == T("Last-Modified"))
+        {
+            rsp.LastModified = value;
+        }
+        else if (key == T("Content-Range"))
+        {
+            // bytes <first>-<last>/<size>
+            FString range, first, last;
+            if (value.Split(T(" "), nullptr, &range) &&
+                range.Split(T("/"), &range, nullptr) &&
+                range.Split(T("-"), &first, &last))
+            {
+                rsp.RangeFirst = FCString::Atoi64(*first);
+                rsp.RangeLast  = FCString::Atoi64(*last);
+            }
+        }
+    }
+
+    rsp.Body.Reset();
+    rsp.Body.Append(raw.GetData() + header, raw.Num() - header);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  Sequential reader over a HTTP pak.  Reads are served one block at a time
+ *  through the owner's block cache; the most recently used block is kept in
+ *  memory since the pak reader tends to issue many small reads per block.
+ */
+class FHttpPakFileHandle : public IFileHandle
+{
+  public:
+
+    FHttpPakFileHandle(FHttpPakPlatformFile& InOwner, TSharedPtr<FHttpPak> InPak)
+        : Owner(InOwner), Pak(InPak), Pos(0), BlockIndex(-1)
+    {}
+
+    virtual int64 Tell() override                 { return Pos; }
+    virtual int64 Size() override                 { return Pak->Size; }
+    virtual bool  Write(const uint8*, int64) override { return false; }
+
+    virtual bool
+    Seek(int64 NewPosition) override
+    {
+        if (NewPosition < 0 || NewPosition > Pak->Size)
+            return false;
+        Pos = NewPosition;
+        return true;
+    }
+
+    virtual bool
+    SeekFromEnd(int64 NewPositionRelativeToEnd = 0) override
+    {
+        return Seek(Pak->Size + NewPositionRelativeToEnd);
+    }
+
+    virtual bool
+    Read(uint8* Destination, int64 BytesToRead) override
+    {
+        if (Pos + BytesToRead > Pak->Size)
+            return false;
+
+        while (BytesToRead > 0)
+        {
+            int64 index = Pos / FHttpPakPlatformFile::BlockSize;
+            if (index != BlockIndex)
+            {
+                if (!Owner.ReadBlock(*Pak, index, Block))
+                {
+                    BlockIndex = -1;
+                    return false;
+                }
+                BlockIndex = index;
+            }
+
+            int64 offset = Pos - index * FHttpPakPlatformFile::BlockSize;
+            int64 len    = FMath::Min(BytesToRead, Block.Num() - offset);
+            if (len <= 0)
+                return false;
+
+            FMemory::Memcpy(Destination, Block.GetData() + offset, len);
+            Destination += len;
+            BytesToRead -= len;
+            Pos         += len;
+        }
+        return true;
+    }
+
+  private:
+
+    FHttpPakPlatformFile& Owner;
+    TSharedPtr<FHttpPak>  Pak;
+    int64                 Pos;
+    int64                 BlockIndex;
+    TArray<uint8>         Block;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+FHttpPakPlatformFile::FHttpPakPlatformFile()
+    : LowerLevel(nullptr), CacheLimit(DEFAULT_CACHE_LIMIT)
+{
+    // Shared by every editor on the host
+    CacheRoot = FPaths::Combine(FPlatformProcess::UserTempDir(), T("ue4orc-pak-blocks"));
+}
+
+bool
+FHttpPakPlatformFile::Initialize(IPlatformFile* Inner, const TCHAR* CmdLine)
+{
+    LowerLevel = Inner;
+    return LowerLevel != nullptr;
+}
+
+void
+FHttpPakPlatformFile::SetCacheLimit(int64 bytes)
+{
+    CacheLimit = bytes;
+    TrimCache();
+}
+
+FString
+FHttpPakPlatformFile::Register(const FString& url)
+{
+    FString rest;
+    if (!url.Split(T("http://"), nullptr, &rest) || rest.Len() == 0)
+    {
+        LOG("Only http:// pak URLs are supported: %s", *url);
+        return FString();
+    }
+
+    TSharedPtr<FHttpPak> pak = MakeShareable(new FHttpPak);
+    FString hostPort;
+    pak->Url  = url;
+    pak->Path = T("/");
+    if (rest.Split(T("/"), &hostPort, &pak->Path))
+        pak->Path = T("/") + pak->Path;
+    else
+        hostPort = rest;
+
+    FString port;
+    pak->Port = 80;
+    pak->Host = hostPort;
+    if (hostPort.Split(T(":"), &pak->Host, &port))
+        pak->Port = FCString::Atoi(*port);
+
+    FString name = FPaths::GetCleanFilename(pak->Path);
+    name.Split(T("?"), &name, nullptr);
+
+    FHttpResponse rsp;
+    if (!http_request(*pak, "HEAD", 0, 0, rsp) || rsp.Status != 200 || rsp.ContentLength < 0)
+    {
+        LOG("HEAD %s failed with status %d", *url, rsp.Status);
+        return FString();
+    }
+    int64 size = rsp.ContentLength;
+
+    /*
+     *  The cache is keyed by the version of the pak as well as its URL, so
+     *  a pak that was replaced on the server is a new pak with blocks of
+     *  its own.  Without a validator only a change of size is noticed.
+     */
+    FString validator = rsp.ETag.Len() > 0 ? rsp.ETag : rsp.LastModified;
+    FString hash = FMD5::HashAnsiString(*FString::Printf(T("%s:%lld:%s"), *url, size, *validator));
+    pak->Size      = size;
+    pak->Validator = validator;
+    pak->CacheDir  = CacheRoot / hash;
+
+    FString filename = FPaths::ConvertRelativePathToFull(
+        FPaths::ProjectSavedDir() / T("HttpPaks") / hash / name);
+    FPaths::NormalizeFilename(filename);
+
+    FScopeLock guard(&Lock);
+    if (Paks.Contains(filename))
+        return filename;
+
+    if (validator.Len() == 0)
+        LOG("%s has neither an ETag nor a Last-Modified header", *url);
+    LOG("Registered %s (%lld bytes) as %s", *url, size, *filename);
+
+    Paks.Add(filename, pak);
+    return filename;
+}
+
+TSharedPtr<FHttpPak>
+FHttpPakPlatformFile::Find(const TCHAR* filename) const
+{
+    FScopeLock guard(&Lock);
+    if (Paks.Num() == 0)
+        return nullptr;
+
+    FString key = FPaths::ConvertRelativePathToFull(filename);
+    FPaths::NormalizeFilename(key);
+
+    const TSharedPtr<FHttpPak>* found = Paks.Find(key);
+    return found ? *found : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  Blocks are stored as individual files.  They are written to a private
+ *  temporary file and renamed into place, so concurrent editors fetching
+ *  the same block never observe a partial one.
+ */
+bool
+FHttpPakPlatformFile::ReadBlock(const FHttpPak& pak, int64 index, TArray<uint8>& out)
+{
+    IPlatformFile& disk = IPlatformFile::GetPlatformPhysical();
+    FString file = pak.CacheDir / FString::Printf(T("%08lld.blk"), index);
+    int64 offset = index * BlockSize;
+    int64 len    = FMath::Min(BlockSize, pak.Size - offset);
+
+    if (len <= 0)
+        return false;
+
+    // Cache hit
+    {
+        TUniquePtr<IFileHandle> handle(disk.OpenRead(*file));
+        if (handle.IsValid() && handle->Size() == len)
+        {
+            out.SetNumUninitialized(len);
+            if (handle->Read(out.GetData(), len))
+            {
+                handle.Reset();
+                disk.SetTimeStamp(*file, FDateTime::UtcNow());
+                return true;
+            }
+        }
+    }
+
+    /*
+     *  Cache miss.  Only a partial response for exactly this block is
+     *  accepted; a server that ignores the range and sends the whole pak,
+     *  or sends some other range, must not end up in the cache.
+     */
+    FHttpResponse rsp;
+    bool fetched = false;
+    for (int attempt = 0; attempt < BLOCK_FETCH_ATTEMPTS && !fetched; attempt++)
+    {
+        fetched = http_request(pak, "GET", offset, len, rsp) &&
+            rsp.Status == 206 &&
+            rsp.RangeFirst == offset &&
+            rsp.RangeLast == offset + len - 1 &&
+            rsp.Body.Num() == len;
+    }
+
+    if (!fetched)
+    {
+        LOG("Fetching block %lld of %s failed with status %d", index, *pak.Url, rsp.Status);
+        return false;
+    }
+    out = MoveTemp(rsp.Body);
+
+    disk.CreateDirectoryTree(*pak.CacheDir);
+    FString temp = file + FString::Printf(T(".%u.tmp"), FPlatformProcess::GetCurrentProcessId());
+    {
+        TUniquePtr<IFileHandle> handle(disk.OpenWrite(*temp));
+        if (!handle.IsValid() || !handle->Write(out.GetData(), len))
+        {
+            handle.Reset();
+            disk.DeleteFile(*temp);
+            return true;    // Serve the block even if it cannot be cached
+        }
+    }
+
+    if (!disk.MoveFile(*file, *temp))
+        disk.DeleteFile(*temp);     // Another editor cached it first
+
+    if (CacheWritten.Add(len) + len > CacheLimit / 8)
+        TrimCache();
+    return true;
+}
+
+/*
+ *  Remove the least recently used blocks of every pak until the cache is
+ *  back under its limit.  Blocks are touched whenever they are read, so
+ *  their timestamps double as last-use times across all editors.
+ */
+void
+FHttpPakPlatformFile::TrimCache()
+{
+    if (!TrimLock.TryLock())
+        return;
+
+    struct FBlock
+    {
+        FString   Path;
+        int64     Size;
+        FDateTime Used;
+    };
+
+    struct FVisitor : public IPlatformFile::FDirectoryStatVisitor
+    {
+        TArray<FBlock> Blocks;
+        int64          Total = 0;
+
+        virtual bool
+        Visit(const TCHAR* path, const FFileStatData& stat) override
+        {
+            if (!stat.bIsDirectory && FString(path).EndsWith(T(".blk")))
+            {
+                Blocks.Add({ path, stat.FileSize, stat.ModificationTime });
+                Total += stat.FileSize;
+            }
+            return true;
+        }
+    } visitor;
+
+    IPlatformFile& disk = IPlatformFile::GetPlatformPhysical();
+    disk.IterateDirectoryStatRecursively(*CacheRoot, visitor);
+    CacheWritten.Set(0);
+
+    if (visitor.Total > CacheLimit)
+    {
+        visitor.Blocks.Sort([](const FBlock& a, const FBlock& b) { return a.Used < b.Used; });
+        for (auto& block : visitor.Blocks)
+        {
+            if (visitor.Total <= CacheLimit)
+                break;
+            if (disk.DeleteFile(*block.Path))
+                visitor.Total -= block.Size;
+        }
+        LOG("Trimmed pak block cache to %lld bytes", visitor.Total);
+    }
+
+    TrimLock.Unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool
+FHttpPakPlatformFile::FileExists(const TCHAR* Filename)
+{
+    return Find(Filename).IsValid() || LowerLevel->FileExists(Filename);
+}
+
+int64
+FHttpPakPlatformFile::FileSize(const TCHAR* Filename)
+{
+    if (auto pak = Find(Filename))
+        return pak->Size;
+    return LowerLevel->FileSize(Filename);
+}
+
+bool
+FHttpPakPlatformFile::DeleteFile(const TCHAR* Filename)
+{
+    if (Find(Filename).IsValid())
+        return false;
+    return LowerLevel->DeleteFile(Filename);
+}
+
+bool
+FHttpPakPlatformFile::IsReadOnly(const TCHAR* Filename)
+{
+    if (Find(Filename).IsValid())
+        return true;
+    return LowerLevel->IsReadOnly(Filename);
+}
+
+bool
+FHttpPakPlatformFile::MoveFile(const TCHAR* To, const TCHAR* From)
+{
+    if (Find(From).IsValid())
+        return false;
+    return LowerLevel->MoveFile(To, From);
+}
+
+bool
+FHttpPakPlatformFile::SetReadOnly(const TCHAR* Filename, bool bNewReadOnlyValue)
+{
+    if (Find(Filename).IsValid())
+        return bNewReadOnlyValue;
+    return LowerLevel->SetReadOnly(Filename, bNewReadOnlyValue);
+}
+
+FDateTime
+FHttpPakPlatformFile::GetTimeStamp(const TCHAR* Filename)
+{
+    if (Find(Filename).IsValid())
+        return FDateTime::MinValue();
+    return LowerLevel->GetTimeStamp(Filename);
+}
+
+void
+FHttpPakPlatformFile::SetTimeStamp(const TCHAR* Filename, FDateTime DateTime)
+{
+    if (!Find(Filename).IsValid())
+        LowerLevel->SetTimeStamp(Filename, DateTime);
+}
+
+FDateTime
+FHttpPakPlatformFile::GetAccessTimeStamp(const TCHAR* Filename)
+{
+    if (Find(Filename).IsValid())
+        return FDateTime::MinValue();
+    return LowerLevel->GetAccessTimeStamp(Filename);
+}
+
+FString
+FHttpPakPlatformFile::GetFilenameOnDisk(const TCHAR* Filename)
+{
+    if (Find(Filename).IsValid())
+        return Filename;
+    return LowerLevel->GetFilenameOnDisk(Filename);
+}
+
+IFileHandle*
+FHttpPakPlatformFile::OpenRead(const TCHAR* Filename, bool bAllowWrite)
+{
+    if (auto pak = Find(Filename))
+        return new FHttpPakFileHandle(*this, pak);
+    return LowerLevel->OpenRead(Filename, bAllowWrite);
+}
+
+IFileHandle*
+FHttpPakPlatformFile::OpenWrite(const TCHAR* Filename, bool bAppend, bool bAllowRead)
+{
+    if (Find(Filename).IsValid())
+        return nullptr;
+    return LowerLevel->OpenWrite(Filename, bAppend, bAllowRead);
+}
+
+IAsyncReadFileHandle*
+FHttpPakPlatformFile::OpenAsyncRead(const TCHAR* Filename)
+{
+    // The generic implementation reads through our OpenRead()
+    if (Find(Filename).IsValid())
+        return IPlatformFile::OpenAsyncRead(Filename);
+    return LowerLevel->OpenAsyncRead(Filename);
+}
+
+bool
+FHttpPakPlatformFile::DirectoryExists(const TCHAR* Directory)
+{
+    return LowerLevel->DirectoryExists(Directory);
+}
+
+bool
+FHttpPakPlatformFile::CreateDirectory(const TCHAR* Directory)
+{
+    return LowerLevel->CreateDirectory(Directory);
+}
+
+bool
+FHttpPakPlatformFile::DeleteDirectory(const TCHAR* Directory)
+{
+    return LowerLevel->DeleteDirectory(Directory);
+}
+
+FFileStatData
+FHttpPakPlatformFile::GetStatData(const TCHAR* FilenameOrDirectory)
+{
+    if (auto pak = Find(FilenameOrDirectory))
+        return FFileStatData(FDateTime::MinValue(), FDateTime::MinValue(), FDateTime::MinValue(),
+                             pak->Size, false, true);
+    return LowerLevel->GetStatData(FilenameOrDirectory);
+}
+
+bool
+FHttpPakPlatformFile::IterateDirectory(const TCHAR* Directory, FDirectoryVisitor& Visitor)
+{
+    return LowerLevel->IterateDirectory(Directory, Visitor);
+}
+
+bool
+FHttpPakPlatformFile::IterateDirectoryStat(const TCHAR* Directory, FDirectoryStatVisitor& Visitor)
+{
+    return LowerLevel->IterateDirectoryStat(Directory, Visitor);
+}
@@ -0,0 +1,106 @@
+/* -*- mode: c; tab-width: 4; indent-tabs-mode: nil; -*- */
+
+#pragma once
+
+#include "UE4Orchestrator.h"
+
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  A pak file that lives on a HTTP server.
+ */
+struct FHttpPak
+{
+    FString Url;
+    FString Host;
+    int32   Port;
+    FString Path;           // Path component of the URL, including the query
+    int64   Size;
+    FString Validator;      // ETag, or else Last-Modified, of this version
+    FString CacheDir;       // Block cache directory for this pak
+};
+
+/*
+ *  FHttpPakPlatformFile sits underneath the pak platform file and serves
+ *  paks that live on a local HTTP object store.
+ *
+ *  A pak registered with `Register()` is exposed under a virtual local
+ *  filename.  Reads of that file are turned into HTTP range requests for
+ *  fixed size blocks, which are kept in an on-disk block cache that is
+ *  shared by every editor on the host.  Mounting a pak only reads its footer
+ *  and index, so only those blocks and the blocks of the assets that are
+ *  actually loaded are ever downloaded.
+ *
+ *  Every other path is passed through to the lower level platform file.
+ */
+class FHttpPakPlatformFile : public IPlatformFile
+{
+  public:
+
+    FHttpPakPlatformFile();
+
+    /*
+     *  Register the pak at `Url` and return the virtual filename it can be
+     *  mounted as, or an empty string if the server could not be reached.
+     */
+    FString Register(const FString& Url);
+
+    /*
+     *  Size the shared block cache is trimmed down to.
+     */
+    void  SetCacheLimit(int64 Bytes);
+    int64 GetCacheLimit() const { return CacheLimit; }
+
+    /*
+     *  Fetch (or find in the cache) block `Index` of `Pak`.
+     */
+    bool ReadBlock(const FHttpPak& Pak, int64 Index, TArray<uint8>& OutData);
+
+    static const int64 BlockSize;
+
+    /*
+     *  IPlatformFile interface.
+     */
+    virtual bool            Initialize(IPlatformFile* Inner, const TCHAR* CmdLine) override;
+    virtual IPlatformFile*  GetLowerLevel() override { return LowerLevel; }
+    virtual void            SetLowerLevel(IPlatformFile* NewLowerLevel) override { LowerLevel = NewLowerLevel; }
+    virtual const TCHAR*    GetName() const override { return T("HttpPakFile"); }
+
+    virtual bool            FileExists(const TCHAR* Filename) override;
+    virtual int64           FileSize(const TCHAR* Filename) override;
+    virtual bool            DeleteFile(const TCHAR* Filename) override;
+    virtual bool            IsReadOnly(const TCHAR* Filename) override;
+    virtual bool            MoveFile(const TCHAR* To, const TCHAR* From) override;
+    virtual bool            SetReadOnly(const TCHAR* Filename, bool bNewReadOnlyValue) override;
+    virtual FDateTime       GetTimeStamp(const TCHAR* Filename) override;
+    virtual void            SetTimeStamp(const TCHAR* Filename, FDateTime DateTime) override;
+    virtual FDateTime       GetAccessTimeStamp(const TCHAR* Filename) override;
+    virtual FString         GetFilenameOnDisk(const TCHAR* Filename) override;
+    virtual IFileHandle*    OpenRead(const TCHAR* Filename, bool bAllowWrite = false) override;
+    virtual IFileHandle*    OpenWrite(const TCHAR* Filename, bool bAppend = false, bool bAllowRead = false) override;
+    virtual IAsyncReadFileHandle* OpenAsyncRead(const TCHAR* Filename) override;
+    virtual bool            DirectoryExists(const TCHAR* Directory) override;
+    virtual bool            CreateDirectory(const TCHAR* Directory) override;
+    virtual bool            DeleteDirectory(const TCHAR* Directory) override;
+    virtual FFileStatData   GetStatData(const TCHAR* FilenameOrDirectory) override;
+    virtual bool            IterateDirectory(const TCHAR* Directory, FDirectoryVisitor& Visitor) override;
+    virtual bool            IterateDirectoryStat(const TCHAR* Directory, FDirectoryStatVisitor& Visitor) override;
+
+  private:
+
+    TSharedPtr<FHttpPak> Find(const TCHAR* Filename) const;
+    void TrimCache();
+
+    IPlatformFile*           LowerLevel;
+
+    mutable FCriticalSection Lock;
+    TMap<FString, TSharedPtr<FHttpPak>> Paks;   // Keyed by virtual filename
+
+    FString                  CacheRoot;
+    int64                    CacheLimit;
+    FThreadSafeCounter64     CacheWritten;  // Bytes added since the last trim
+    FCriticalSection         TrimLock;
+};
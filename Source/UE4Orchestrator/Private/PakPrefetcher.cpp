@@ -0,0 +1,238 @@
+/* -*- mode: c; tab-width: 4; indent-tabs-mode: nil; -*- */
+
+/*
+ *  UE4Orchestrator.h acts as the PCH for this project and must be the
+ *  very first file imported.
+ */
+#include "UE4Orchestrator.h"
+
+#include "PakPrefetcher.h"
+
+#include "HAL/PlatformFilemanager.h"
+
+#if PLATFORM_LINUX
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Size of each sequential read issued while warming a pak.
+static const int64 PREFETCH_BLOCK_SIZE = 1024 * 1024;
+
+static FString
+prefetch_key(const FString& pakPath)
+{
+    FString key = pakPath;
+    FPaths::NormalizeFilename(key);
+    return key;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+FPakPrefetcher::FPakPrefetcher()
+    : BytesWarmed(0), Wake(nullptr), Thread(nullptr)
+{
+    Wake   = FPlatformProcess::GetSynchEventFromPool(false);
+    Thread = FRunnableThread::Create(this, T("UE4OrcPakPrefetcher"), 0, TPri_Lowest);
+}
+
+FPakPrefetcher::~FPakPrefetcher()
+{
+    if (Thread != nullptr)
+    {
+        Thread->Kill(true);
+        delete Thread;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(Wake);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void
+FPakPrefetcher::Enqueue(const FString& pakPath)
+{
+    FString key = prefetch_key(pakPath);
+    {
+        FScopeLock guard(&Lock);
+        FEntry* entry = Entries.Find(key);
+        if (entry != nullptr && (Queue.Contains(key) || key == Current))
+            return;
+
+        if (entry == nullptr)
+            entry = &Entries.Add(key);
+        entry->PakPath     = pakPath;
+        entry->BytesTotal  = 0;
+        entry->BytesWarmed = 0;
+        entry->State       = T("queued");
+        Queue.Add(key);
+    }
+    Wake->Trigger();
+}
+
+void
+FPakPrefetcher::SetUpcoming(const TArray<FString>& pakPaths)
+{
+    {
+        FScopeLock guard(&Lock);
+        for (auto& key : Queue)
+            Entries.Remove(key);
+        Queue.Reset();
+    }
+
+    for (auto& pak : pakPaths)
+        Enqueue(pak);
+}
+
+void
+FPakPrefetcher::Forget(const FString& pakPath)
+{
+    FString key = prefetch_key(pakPath);
+    FScopeLock guard(&Lock);
+    if (key == Current)
+    {
+        Current.Empty();        // Stops Warm()
+        Entries.Remove(key);
+    }
+    else if (Queue.Remove(key) > 0)
+    {
+        Entries.Remove(key);
+    }
+}
+
+TSharedRef<FJsonObject>
+FPakPrefetcher::GetStatus() const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    TArray<TSharedPtr<FJsonValue>> paks;
+
+    FScopeLock guard(&Lock);
+    for (auto& it : Entries)
+    {
+        TSharedRef<FJsonObject> pak = MakeShareable(new FJsonObject);
+        pak->SetStringField(T("pak_path"), it.Value.PakPath);
+        pak->SetStringField(T("state"), it.Value.State);
+        pak->SetNumberField(T("bytes_total"), it.Value.BytesTotal);
+        pak->SetNumberField(T("bytes_warmed"), it.Value.BytesWarmed);
+        paks.Add(MakeShareable(new FJsonValueObject(pak)));
+    }
+
+    ret->SetNumberField(T("bytes_warmed"), BytesWarmed);
+    ret->SetNumberField(T("queued"), Queue.Num());
+    ret->SetArrayField(T("paks"), paks);
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32
+FPakPrefetcher::Run()
+{
+    while (!bStop)
+    {
+        FString key;
+        {
+            FScopeLock guard(&Lock);
+            if (Queue.Num() > 0)
+            {
+                key     = Queue[0];
+                Current = key;
+                Queue.RemoveAt(0);
+            }
+        }
+
+        if (key.Len() == 0)
+        {
+            Wake->Wait(1000);
+            continue;
+        }
+
+        Warm(key);
+
+        FScopeLock guard(&Lock);
+        Current.Empty();
+    }
+    return 0;
+}
+
+void
+FPakPrefetcher::Stop()
+{
+    bStop = true;
+    Wake->Trigger();
+}
+
+/*
+ *  Read the pak front to back so that every page of it ends up in the OS
+ *  page cache.  The data itself is discarded.
+ */
+void
+FPakPrefetcher::Warm(const FString& key)
+{
+    FString pakPath;
+    {
+        FScopeLock guard(&Lock);
+        FEntry* entry = Entries.Find(key);
+        if (entry == nullptr)
+            return;
+        entry->State = T("warming");
+        pakPath = entry->PakPath;
+    }
+
+    IPlatformFile& platform = IPlatformFile::GetPlatformPhysical();
+    TUniquePtr<IFileHandle> handle(platform.OpenRead(*pakPath));
+
+    auto finish = [&](const TCHAR* state) {
+        FScopeLock guard(&Lock);
+        if (FEntry* entry = Current == key ? Entries.Find(key) : nullptr)
+            entry->State = state;
+    };
+
+    if (!handle.IsValid())
+    {
+        LOG("Prefetch of %s failed, unable to open file", *pakPath);
+        finish(T("failed"));
+        return;
+    }
+
+    int64 size = handle->Size();
+    {
+        FScopeLock guard(&Lock);
+        if (FEntry* entry = Current == key ? Entries.Find(key) : nullptr)
+            entry->BytesTotal = size;
+    }
+
+#if PLATFORM_LINUX
+    // Let the kernel start reading ahead of us straight away.
+    int fd = open(TCHAR_TO_UTF8(*pakPath), O_RDONLY);
+    if (fd >= 0)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+    }
+#endif
+
+    TArray<uint8> buffer;
+    buffer.SetNumUninitialized(PREFETCH_BLOCK_SIZE);
+
+    for (int64 offset = 0; offset < size && !bStop; offset += PREFETCH_BLOCK_SIZE)
+    {
+        int64 len = FMath::Min(PREFETCH_BLOCK_SIZE, size - offset);
+        if (!handle->Read(buffer.GetData(), len))
+        {
+            LOG("Prefetch of %s failed at offset %lld", *pakPath, offset);
+            finish(T("failed"));
+            return;
+        }
+
+        FScopeLock guard(&Lock);
+        BytesWarmed += len;
+        if (FEntry* entry = Current == key ? Entries.Find(key) : nullptr)
+            entry->BytesWarmed += len;
+        else
+            return;     // Mounted or dropped while we were reading it.
+    }
+
+    finish(bStop ? T("queued") : T("warm"));
+}
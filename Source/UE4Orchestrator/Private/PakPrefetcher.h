@@ -0,0 +1,77 @@
+/* -*- mode: c; tab-width: 4; indent-tabs-mode: nil; -*- */
+
+#pragma once
+
+#include "UE4Orchestrator.h"
+
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  FPakPrefetcher warms the OS page cache with the contents of pak files
+ *  before they are mounted.  Paks are read sequentially on a low priority
+ *  background thread so that the subsequent `MountPakFile` and content load
+ *  are served from memory instead of a cold disk.
+ *
+ *  All public methods are safe to call from the game thread.
+ */
+class FPakPrefetcher : public FRunnable
+{
+  public:
+
+    FPakPrefetcher();
+    virtual ~FPakPrefetcher();
+
+    /*
+     *  Queue a pak to be warmed.  Paks that are already queued or being
+     *  warmed are ignored; paks that were warmed before, or failed, are
+     *  queued again since their pages may have been evicted since.
+     */
+    void Enqueue(const FString& PakPath);
+
+    /*
+     *  Replace the list of paks that are expected to be mounted next.
+     *  Pending paks that are no longer in the list are dropped, and the new
+     *  list is warmed in order.
+     */
+    void SetUpcoming(const TArray<FString>& PakPaths);
+
+    /*
+     *  Called once a pak has been mounted; it is dropped from the pending
+     *  queue, and warming it stops, if it has not been warmed yet.
+     */
+    void Forget(const FString& PakPath);
+
+    TSharedRef<FJsonObject> GetStatus() const;
+
+    /*
+     *  FRunnable interface.
+     */
+    virtual uint32 Run() override;
+    virtual void   Stop() override;
+
+  private:
+
+    struct FEntry
+    {
+        FString PakPath;
+        int64   BytesTotal;
+        int64   BytesWarmed;
+        FString State;          // "queued", "warming", "warm" or "failed"
+    };
+
+    void Warm(const FString& PakPath);
+
+    mutable FCriticalSection Lock;
+    TArray<FString>          Queue;         // Keys waiting to be warmed
+    FString                  Current;       // Key being warmed, if any
+    TMap<FString, FEntry>    Entries;
+    int64                    BytesWarmed;
+
+    FEvent*                  Wake;
+    FRunnableThread*         Thread;
+    FThreadSafeBool          bStop;
+};
@@ -0,0 +1,274 @@
+/* -*- mode: c; tab-width: 4; indent-tabs-mode: nil; -*- */
+
+/*
+ *  UE4Orchestrator.h acts as the PCH for this project and must be the
+ *  very first file imported.
+ */
+#include "UE4Orchestrator.h"
+
+#include "ShaderWorkerControl.h"
+
+#if PLATFORM_LINUX
+#  include <dirent.h>
+#  include <errno.h>
+#  include <sched.h>
+#  include <stdio.h>
+#  include <stdlib.h>
+#  include <string.h>
+#  include <unistd.h>
+#  include <sys/resource.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// How often workers are enumerated and sampled.
+static const double SAMPLE_INTERVAL_S = 1.0;
+
+#if PLATFORM_LINUX
+
+/*
+ *  Parse /proc/<pid>/stat.  The command name is in parentheses and may
+ *  itself contain spaces or parentheses, so fields are counted from the
+ *  last ')'.
+ */
+static bool
+read_proc_stat(int32 pid, FString& comm, int32& ppid, uint64& cpuTicks)
+{
+    char path[64];
+    char buf[1024];
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE* f = fopen(path, "r");
+    if (f == nullptr)
+        return false;
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[len] = 0;
+
+    char* open  = strchr(buf, '(');
+    char* close = strrchr(buf, ')');
+    if (open == nullptr || close == nullptr || close < open)
+        return false;
+
+    *close = 0;
+    comm = UTF8_TO_TCHAR(open + 1);
+
+    // Fields after the name: state, ppid, ... utime is the 12th, stime the 13th
+    unsigned long long utime = 0, stime = 0;
+    int parent = 0;
+    int n = sscanf(close + 2, "%*c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                   &parent, &utime, &stime);
+    if (n != 3)
+        return false;
+
+    ppid     = parent;
+    cpuTicks = utime + stime;
+    return true;
+}
+
+/*
+ *  Collect the pids of this process's children.  Each thread lists the
+ *  children it spawned in /proc/self/task/<tid>/children, so only our own
+ *  threads are visited instead of every process on the host.
+ */
+static void
+read_children(TArray<int32>& pids)
+{
+    DIR* tasks = opendir("/proc/self/task");
+    if (tasks == nullptr)
+        return;
+
+    while (struct dirent* entry = readdir(tasks))
+    {
+        if (atoi(entry->d_name) <= 0)
+            continue;
+
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/self/task/%s/children", entry->d_name);
+        FILE* f = fopen(path, "r");
+        if (f == nullptr)
+            continue;
+
+        int pid;
+        while (fscanf(f, "%d", &pid) == 1)
+            pids.Add(pid);
+        fclose(f);
+    }
+    closedir(tasks);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+FShaderWorkerControl::FShaderWorkerControl()
+    : bConfigured(false), Cores(0), Nice(0), LastSample(0.0), Utilization(0.0)
+{
+    MachineCores = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+}
+
+void
+FShaderWorkerControl::Tick()
+{
+    double now = FPlatformTime::Seconds();
+    if (now - LastSample < SAMPLE_INTERVAL_S)
+        return;
+
+    Sample();
+    LastSample = now;
+}
+
+void
+FShaderWorkerControl::Configure(int32 cores, int32 nice)
+{
+    Cores       = FMath::Clamp(cores, 0, MachineCores);
+    Nice        = FMath::Clamp(nice, -20, 19);
+    bConfigured = true;
+
+    LOG("Shader workers limited to %d cores at nice %d", Cores, Nice);
+    for (auto& it : Workers)
+        Apply(it.Value);
+}
+
+TSharedRef<FJsonObject>
+FShaderWorkerControl::GetStatus() const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    TArray<TSharedPtr<FJsonValue>> workers;
+
+    for (auto& it : Workers)
+    {
+        TSharedRef<FJsonObject> worker = MakeShareable(new FJsonObject);
+        worker->SetNumberField(T("pid"), it.Value.Pid);
+        worker->SetNumberField(T("cpu_percent"), it.Value.CpuPercent);
+        worker->SetNumberField(T("nice"), it.Value.EffectiveNice);
+        if (it.Value.Error.Len() > 0)
+            worker->SetStringField(T("error"), it.Value.Error);
+        workers.Add(MakeShareable(new FJsonValueObject(worker)));
+    }
+
+    ret->SetBoolField(T("supported"), PLATFORM_LINUX != 0);
+    ret->SetBoolField(T("configured"), bConfigured);
+    ret->SetNumberField(T("machine_cores"), MachineCores);
+    ret->SetNumberField(T("cores"), Cores);
+    ret->SetNumberField(T("nice"), Nice);
+    ret->SetNumberField(T("utilization"), Utilization);
+    ret->SetArrayField(T("workers"), workers);
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  Find the ShaderCompileWorker children of this process, configure the
+ *  ones that are new once limits have been set, and measure how much CPU
+ *  each used since the last sample.
+ */
+void
+FShaderWorkerControl::Sample()
+{
+#if PLATFORM_LINUX
+    TArray<int32> children;
+    read_children(children);
+
+    int32  self    = getpid();
+    double elapsed = FPlatformTime::Seconds() - LastSample;
+    double hz      = sysconf(_SC_CLK_TCK);
+    double total   = 0.0;
+    TSet<int32> seen;
+
+    for (int32 pid : children)
+    {
+        FString comm;
+        int32   ppid;
+        uint64  ticks;
+
+        // The kernel truncates command names to 15 characters
+        if (!read_proc_stat(pid, comm, ppid, ticks) || ppid != self ||
+            !comm.StartsWith(T("ShaderCompileWo")))
+            continue;
+
+        seen.Add(pid);
+        FWorker* worker = Workers.Find(pid);
+        if (worker == nullptr)
+        {
+            worker = &Workers.Add(pid);
+            worker->Pid         = pid;
+            worker->CpuTicks    = ticks;
+            worker->CpuPercent  = 0.0;
+            worker->bApplied    = false;
+
+            errno = 0;
+            int prio = getpriority(PRIO_PROCESS, pid);
+            worker->EffectiveNice = errno == 0 ? prio : 0;
+        }
+        else if (LastSample > 0.0 && elapsed > 0.0)
+        {
+            worker->CpuPercent = (ticks - worker->CpuTicks) / hz / elapsed * 100.0;
+            worker->CpuTicks   = ticks;
+        }
+
+        if (bConfigured && !worker->bApplied)
+            Apply(*worker);
+        total += worker->CpuPercent;
+    }
+
+    for (auto it = Workers.CreateIterator(); it; ++it)
+    {
+        if (!seen.Contains(it.Key()))
+            it.RemoveCurrent();
+    }
+
+    int32 cores = Cores > 0 ? Cores : MachineCores;
+    Utilization = cores > 0 ? total / 100.0 / cores : 0.0;
+#endif
+}
+
+/*
+ *  Apply the core limit and priority to every thread of a worker.  Workers
+ *  are confined to the last `Cores` cores, leaving the first ones, where
+ *  the game and render threads tend to run, to the editor.
+ */
+void
+FShaderWorkerControl::Apply(FWorker& worker)
+{
+#if PLATFORM_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int32 first = Cores > 0 ? MachineCores - Cores : 0;
+    for (int32 cpu = first; cpu < MachineCores; cpu++)
+        CPU_SET(cpu, &set);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", worker.Pid);
+    DIR* tasks = opendir(path);
+    if (tasks == nullptr)
+        return;
+
+    worker.Error.Empty();
+    while (struct dirent* entry = readdir(tasks))
+    {
+        int32 tid = atoi(entry->d_name);
+        if (tid <= 0)
+            continue;
+
+        if (sched_setaffinity(tid, sizeof(set), &set) != 0 && worker.Error.Len() == 0)
+            worker.Error = FString::Printf(T("affinity: %s"), UTF8_TO_TCHAR(strerror(errno)));
+
+        // Lowering niceness again needs privileges, see Configure()
+        if (setpriority(PRIO_PROCESS, tid, Nice) != 0 && worker.Error.Len() == 0)
+            worker.Error = FString::Printf(T("nice %d: %s"), Nice, UTF8_TO_TCHAR(strerror(errno)));
+    }
+    closedir(tasks);
+
+    // getpriority() can legitimately return -1, so errno tells failures apart
+    errno = 0;
+    int prio = getpriority(PRIO_PROCESS, worker.Pid);
+    if (errno == 0)
+        worker.EffectiveNice = prio;
+
+    if (worker.Error.Len() > 0)
+        LOG("Unable to limit shader worker %d: %s", worker.Pid, *worker.Error);
+#endif
+    worker.bApplied = true;
+}
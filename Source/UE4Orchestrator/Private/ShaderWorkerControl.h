@@ -0,0 +1,67 @@
+/* -*- mode: c; tab-width: 4; indent-tabs-mode: nil; -*- */
+
+#pragma once
+
+#include "UE4Orchestrator.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  FShaderWorkerControl shifts CPU between shader compilation and the rest
+ *  of the host at runtime.  The shader compiling manager only reads its
+ *  worker count from the ini files at startup, so instead the
+ *  ShaderCompileWorker processes spawned by this editor are confined to a
+ *  number of cores and given a scheduling priority, which bounds how much
+ *  of the machine they can use.  Their CPU usage is sampled to report
+ *  utilization.
+ *
+ *  Workers are left as the engine started them until `Configure()` is
+ *  first called.  Only Linux is supported; elsewhere the status reports as
+ *  much.  All methods are called from the game thread.
+ */
+class FShaderWorkerControl
+{
+  public:
+
+    FShaderWorkerControl();
+
+    /*
+     *  Called every tick.  Once a second the workers are enumerated, new
+     *  ones are configured and their CPU usage is sampled.
+     */
+    void Tick();
+
+    /*
+     *  Confine workers to `Cores` cores (0 for all of them) and run them at
+     *  niceness `Nice`.  Applies to running and future workers.  Without
+     *  CAP_SYS_NICE (or a matching RLIMIT_NICE) niceness can only be
+     *  raised, so running workers keep a higher one; each worker reports
+     *  the niceness it actually has.
+     */
+    void Configure(int32 Cores, int32 Nice);
+
+    TSharedRef<FJsonObject> GetStatus() const;
+
+  private:
+
+    struct FWorker
+    {
+        int32  Pid;
+        uint64 CpuTicks;        // User and system time at the last sample
+        double CpuPercent;      // Of one core, over the last sample period
+        bool   bApplied;        // Current limits have been applied
+        int32  EffectiveNice;   // Read back after applying them
+        FString Error;          // Why they could not all be applied
+    };
+
+    void Sample();
+    void Apply(FWorker& Worker);
+
+    TMap<int32, FWorker> Workers;
+    bool                 bConfigured;   // Configure() has been called
+    int32                Cores;
+    int32                Nice;
+    int32                MachineCores;
+    double               LastSample;
+    double               Utilization;   // Of the cores workers may use
+};
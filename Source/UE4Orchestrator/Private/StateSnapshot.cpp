@@ -0,0 +1,198 @@
+/* -*- mode: c; tab-width: 4; indent-tabs-mode: nil; -*- */
+
+/*
+ *  UE4Orchestrator.h acts as the PCH for this project and must be the
+ *  very first file imported.
+ */
+#include "UE4Orchestrator.h"
+
+#include "StateSnapshot.h"
+
+#include "Serialization/JsonSerializer.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// How long the status thread blocks in each poll; bounds shutdown latency.
+static const int STATUS_POLL_MS = 100;
+
+TSharedRef<FJsonObject>
+FEngineState::ToJson(uint64 version) const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+
+    ret->SetNumberField(T("version"), version);
+    ret->SetNumberField(T("frame"), Frame);
+    ret->SetNumberField(T("age_ms"), (FPlatformTime::Seconds() - Published) * 1000.0);
+    ret->SetNumberField(T("tick_ms"), TickMs);
+    ret->SetBoolField(T("async_loading"), bAsyncLoading);
+    ret->SetBoolField(T("registry_loading"), bRegistryLoading);
+    ret->SetBoolField(T("play_in_editor"), bPlayInEditor);
+    ret->SetBoolField(T("compiling_shaders"), bCompilingShaders);
+    ret->SetBoolField(T("garbage_collecting"), bGarbageCollecting);
+    ret->SetBoolField(T("orchestrated"), bOrchestrated);
+    ret->SetNumberField(T("shader_jobs"), ShaderJobs);
+    ret->SetNumberField(T("inflight_loads"), InFlightLoads);
+    ret->SetNumberField(T("mounted_paks"), MountedPaks);
+    ret->SetNumberField(T("uploads"), Uploads);
+    ret->SetNumberField(T("jobs"), Jobs);
+    ret->SetNumberField(T("deferred_replies"), DeferredReplies);
+    ret->SetNumberField(T("rss_bytes"), UsedPhysical);
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+FStateSnapshot::FStateSnapshot()
+{
+    FMemory::Memzero(State);
+}
+
+void
+FStateSnapshot::Publish(const FEngineState& state)
+{
+    // Increments are interlocked, so they also act as full barriers
+    Sequence.Increment();
+    State = state;
+    Sequence.Increment();
+}
+
+uint64
+FStateSnapshot::Read(FEngineState& outState) const
+{
+    for (;;)
+    {
+        int64 before = Sequence.GetValue();
+        if (before & 1)
+        {
+            FPlatformProcess::Yield();
+            continue;
+        }
+
+        FPlatformMisc::MemoryBarrier();
+        outState = State;
+        FPlatformMisc::MemoryBarrier();
+
+        if (Sequence.GetValue() == before)
+            return before / 2;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Matches `uri` with or without the "/ue4" prefix the main port accepts.
+static bool
+status_uri_is(http_message_t* msg, const char* uri)
+{
+    mg_str_t path = msg->uri;
+    if (path.len > 4 && strncmp(path.p, "/ue4/", 5) == 0)
+    {
+        path.p   += 4;
+        path.len -= 4;
+    }
+    return mg_vcmp(&path, uri) == 0;
+}
+
+static void
+status_send(struct mg_connection* conn, int status, const char* headers, const FString& body)
+{
+    FTCHARToUTF8 utf8(*body);
+    mg_send_head(conn, status, utf8.Length(), headers);
+    mg_send(conn, utf8.Get(), utf8.Length());
+}
+
+/*
+ *  Runs on the status thread.  Nothing here may touch the engine; every
+ *  answer comes from the snapshot.
+ */
+static void
+status_handler(struct mg_connection* conn, int ev, void* ev_data)
+{
+    if (ev != MG_EV_HTTP_REQUEST)
+        return;
+
+    http_message_t* msg    = (http_message_t *)ev_data;
+    FStatusServer*  server = (FStatusServer *)conn->mgr->user_data;
+    const char*     text   = "Content-Type: text/plain";
+
+    FEngineState state;
+    uint64 version = server->GetSnapshot().Read(state);
+
+    if (mg_vcmp(&msg->method, "GET") != 0)
+    {
+        status_send(conn, 404, text, T("ERROR\r\n"));
+    }
+    else if (status_uri_is(msg, "/"))
+    {
+        status_send(conn, 200, text, T("OK\r\n"));
+    }
+    else if (status_uri_is(msg, "/assets_idle"))
+    {
+        if (version == 0 || state.bRegistryLoading)
+            status_send(conn, 416, text, T("TRY AGAIN\r\n"));
+        else
+            status_send(conn, 200, text, T("OK\r\n"));
+    }
+    else if (status_uri_is(msg, "/status"))
+    {
+        if (version == 0)
+        {
+            status_send(conn, 503, text, T("TRY AGAIN\r\n"));
+            return;
+        }
+
+        FString json;
+        auto writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&json);
+        FJsonSerializer::Serialize(state.ToJson(version), writer);
+        status_send(conn, 200, "Content-Type: application/json", json);
+    }
+    else
+    {
+        status_send(conn, 404, text, T("ERROR\r\n"));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+FStatusServer::FStatusServer(const FStateSnapshot& snapshot, const char* port)
+    : Snapshot(snapshot), Port(port), Thread(nullptr)
+{
+    Thread = FRunnableThread::Create(this, T("UE4OrcStatusServer"), 0, TPri_BelowNormal);
+}
+
+FStatusServer::~FStatusServer()
+{
+    if (Thread != nullptr)
+    {
+        Thread->Kill(true);
+        delete Thread;
+    }
+}
+
+uint32
+FStatusServer::Run()
+{
+    struct mg_mgr mgr;
+    mg_mgr_init(&mgr, this);
+
+    struct mg_connection* conn = mg_bind(&mgr, TCHAR_TO_UTF8(*Port), status_handler);
+    if (conn == nullptr)
+    {
+        LOG("Unable to bind the status port %s", *Port);
+        mg_mgr_free(&mgr);
+        return 1;
+    }
+    mg_set_protocol_http_websocket(conn);
+
+    while (!bStop)
+        mg_mgr_poll(&mgr, STATUS_POLL_MS);
+
+    mg_mgr_free(&mgr);
+    return 0;
+}
+
+void
+FStatusServer::Stop()
+{
+    bStop = true;
+}
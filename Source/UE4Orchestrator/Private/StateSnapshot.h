@@ -0,0 +1,103 @@
+/* -*- mode: c; tab-width: 4; indent-tabs-mode: nil; -*- */
+
+#pragma once
+
+#include "UE4Orchestrator.h"
+
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  The engine state that read-only queries are answered from.  This is
+ *  plain data so that it can be copied without locks or allocation.
+ */
+struct FEngineState
+{
+    uint64 Frame;
+    double Published;           // FPlatformTime::Seconds() when captured
+    double TickMs;              // Smoothed game thread tick interval
+
+    bool   bAsyncLoading;       // Async package loading, including our own
+    bool   bRegistryLoading;    // The asset registry is discovering assets
+    bool   bPlayInEditor;
+    bool   bCompilingShaders;
+    bool   bGarbageCollecting;  // A collection is pending or being purged
+    bool   bOrchestrated;
+
+    int32  ShaderJobs;
+    int32  InFlightLoads;
+    int32  MountedPaks;
+    int32  Uploads;
+    int32  Jobs;
+    int32  DeferredReplies;
+
+    uint64 UsedPhysical;
+
+    TSharedRef<FJsonObject> ToJson(uint64 Version) const;
+};
+
+/*
+ *  FStateSnapshot holds the latest FEngineState published by the game
+ *  thread, protected by a sequence lock: the writer makes the sequence odd
+ *  while it copies the state in, and readers retry until they copied it
+ *  between two reads of the same even sequence.  The game thread never
+ *  waits on a reader.
+ */
+class FStateSnapshot
+{
+  public:
+
+    FStateSnapshot();
+
+    /*
+     *  Game thread only.
+     */
+    void Publish(const FEngineState& State);
+
+    /*
+     *  Any thread.  Returns the version of the copied state, or 0 if
+     *  nothing has been published yet.
+     */
+    uint64 Read(FEngineState& OutState) const;
+
+  private:
+
+    FThreadSafeCounter64 Sequence;
+    FEngineState         State;
+};
+
+/*
+ *  FStatusServer answers health and status probes on a port of its own
+ *  from its own thread, using only the published snapshot, so that probes
+ *  are answered even while the game thread is stuck in a long frame.
+ *
+ *      GET /               "OK"
+ *      GET /assets_idle    "OK", or 416 while the registry is loading
+ *      GET /status         The snapshot as JSON
+ */
+class FStatusServer : public FRunnable
+{
+  public:
+
+    FStatusServer(const FStateSnapshot& Snapshot, const char* Port);
+    virtual ~FStatusServer();
+
+    const FStateSnapshot& GetSnapshot() const { return Snapshot; }
+
+    /*
+     *  FRunnable interface.
+     */
+    virtual uint32 Run() override;
+    virtual void   Stop() override;
+
+  private:
+
+    const FStateSnapshot&    Snapshot;
+    FString                  Port;
+
+    FRunnableThread*         Thread;
+    FThreadSafeBool          bStop;
+};
@@ -20,16 +20,36 @@
 #include "Runtime/Engine/Classes/Engine/AssetManager.h"
 #include "Runtime/Engine/Public/ShaderCompiler.h"
 #include "Runtime/Engine/Public/UnrealEngine.h"
+#include "Runtime/Engine/Classes/Engine/StaticMesh.h"
+#include "Runtime/Engine/Classes/Engine/SkeletalMesh.h"
+#include "Runtime/Engine/Classes/Engine/Texture2D.h"
+#include "Runtime/Engine/Public/StaticMeshResources.h"
+#include "Runtime/Engine/Public/SkeletalMeshTypes.h"
+#include "Runtime/Engine/Public/MaterialShared.h"
+#include "Runtime/Engine/Classes/Materials/MaterialInterface.h"
+#include "UObject/UObjectIterator.h"
+#include "Runtime/RenderCore/Public/RenderCommandFence.h"
+#include "Runtime/Engine/Public/ContentStreaming.h"
+#include "Runtime/Engine/Public/EngineUtils.h"
+#include "Runtime/Engine/Classes/Components/PrimitiveComponent.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
 
 #if WITH_EDITOR
 #  include "LevelEditor.h"
 #  include "Editor.h"
+#  include "Editor/UnrealEd/Classes/Editor/EditorPerformanceSettings.h"
 #  include "Editor/LevelEditor/Public/ILevelViewport.h"
 #  include "Editor/LevelEditor/Public/LevelEditorActions.h"
 #  include "Editor/UnrealEd/Public/LevelEditorViewport.h"
 #endif
 
 #include "UE4OrchestratorPrivate.h"
+#include "PakPrefetcher.h"
+#include "HttpPakPlatformFile.h"
+#include "ShaderWorkerControl.h"
+#include "StateSnapshot.h"
 
 // HTTP server
 #include "mongoose.h"
@@ -48,21 +68,179 @@ debugFn(FString payload)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Serialize a JSON object for a HTTP response.
+static FString
+json_to_string(const TSharedRef<FJsonObject>& obj)
+{
+    FString out;
+    auto writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&out);
+    FJsonSerializer::Serialize(obj, writer);
+    return out;
+}
+
+static FString
+pak_key(const FString& pakPath)
+{
+    FString key = pakPath;
+    FPaths::NormalizeFilename(key);
+    return key;
+}
+
+static int64
+resident_bytes(UObject* obj)
+{
+    return obj ? obj->GetResourceSizeBytes(EResourceSizeMode::Exclusive) : 0;
+}
+
+FPakContentFilter
+FPakContentFilter::Parse(const FString& spec)
+{
+    FPakContentFilter ret(true);
+    TArray<FString> terms;
+
+    if (spec == T("all"))
+        return ret;
+    if (spec == T("none"))
+        return FPakContentFilter(false);
+
+    spec.ParseIntoArray(terms, T(";"), true);
+    for (auto term : terms)
+    {
+        term.TrimStartAndEndInline();
+        if (term.StartsWith(T("class=")))
+            ret.Classes.Add(FName(*term.Mid(6)));
+        else if (term.StartsWith(T("!")))
+            ret.Exclude.Add(term.Mid(1));
+        else if (term.Len() > 0)
+            ret.Include.Add(term);
+    }
+    return ret;
+}
+
+FPakContentFilter
+FPakContentFilter::FromJson(const TSharedPtr<FJsonObject>& json)
+{
+    FString load;
+    if (json->TryGetStringField(T("load"), load) && load != T("all"))
+        return Parse(load);
+
+    FPakContentFilter ret(load == T("all"));
+    TArray<FString> classes;
+
+    json->TryGetStringArrayField(T("include"), ret.Include);
+    json->TryGetStringArrayField(T("exclude"), ret.Exclude);
+    json->TryGetStringArrayField(T("classes"), classes);
+    for (auto& cls : classes)
+        ret.Classes.Add(FName(*cls));
+
+    // Specifying any filter implies that content should be loaded
+    ret.bLoad |= ret.Include.Num() > 0 || ret.Classes.Num() > 0;
+    return ret;
+}
+
+bool
+FPakContentFilter::MatchesPath(const FString& file) const
+{
+    for (auto& pattern : Exclude)
+        if (FWildcardString::IsMatch(*pattern, *file))
+            return false;
+
+    if (Include.Num() == 0)
+        return true;
+
+    for (auto& pattern : Include)
+        if (FWildcardString::IsMatch(*pattern, *file))
+            return true;
+    return false;
+}
+
+bool
+FPakContentFilter::MatchesClass(const FAssetData& asset) const
+{
+    if (Classes.Num() == 0)
+        return true;
+    return asset.IsValid() && Classes.Contains(asset.AssetClass);
+}
+
 int
 URCHTTP::MountPakFile(const FString& pakPath, bool bLoadContent)
+{
+    return MountPakFile(pakPath, FPakContentFilter(bLoadContent));
+}
+
+/*
+ *  Paks served over HTTP are mounted through a virtual local filename.
+ */
+FString
+URCHTTP::ResolvePakPath(const FString& pakPath) const
+{
+    if (pakPath.StartsWith(T("http://")))
+        return HttpPakFile->Register(pakPath);
+    return pakPath;
+}
+
+/*
+ *  Sort `roots` and the packages of the pak that they depend on into
+ *  layers, where each package only depends on packages in earlier layers.
+ *  Dependency cycles are broken arbitrarily.
+ */
+static TArray<TArray<FName>>
+dependency_layers(IAssetRegistry& registry, const TMap<FName, FString>& pakPackages,
+                  const TArray<FName>& roots)
+{
+    TArray<TArray<FName>> layers;
+    TMap<FName, int32>    depth;    // -1 while a package is being visited
+
+    TFunction<int32(FName)> visit = [&](FName pkg) -> int32
+    {
+        if (int32* found = depth.Find(pkg))
+            return *found;
+        depth.Add(pkg, -1);
+
+        TArray<FName> deps;
+        registry.GetDependencies(pkg, deps, EAssetRegistryDependencyType::Hard);
+
+        int32 d = 0;
+        for (auto& dep : deps)
+        {
+            if (dep != pkg && pakPackages.Contains(dep))
+                d = FMath::Max(d, visit(dep) + 1);
+        }
+
+        depth[pkg] = d;
+        if (layers.Num() <= d)
+            layers.SetNum(d + 1);
+        layers[d].Add(pkg);
+        return d;
+    };
+
+    for (auto& pkg : roots)
+        visit(pkg);
+    return layers;
+}
+
+int
+URCHTTP::MountPakFile(const FString& requestedPath, const FPakContentFilter& filter)
 {
     int ret = 0;
-    IPlatformFile *originalPlatform = &FPlatformFileManager::Get().GetPlatformFile();
+    FString pakPath = ResolvePakPath(requestedPath);
+    FString key = pak_key(pakPath);
 
     // Check to see if the file exists first
-    if (!originalPlatform->FileExists(*pakPath))
+    if (pakPath.Len() == 0 || !HttpPakFile->FileExists(*pakPath))
     {
-        LOG("PakFile %s does not exist", *pakPath);
+        LOG("PakFile %s does not exist", *requestedPath);
         return -1;
     }
 
-    // The pak reader is now the current platform file
-    FPlatformFileManager::Get().SetPlatformFile(*PakFileMgr);
+    // Re-mounting a pak only refreshes its book-keeping
+    if (FMountedPak* mounted = MountedPaks.Find(key))
+    {
+        LOG("PakFile %s is already mounted at %s", *pakPath, *mounted->MountPoint);
+        mounted->LastUse = FPlatformTime::Seconds();
+        if (!filter.bLoad)
+            return 0;
+    }
 
     // Get the mount point from the Pak meta-data
     FPakFile PakFile(PakFileMgr, *pakPath, false);
@@ -70,295 +248,2877 @@ URCHTTP::MountPakFile(const FString& pakPath, bool bLoadContent)
 
     // Determine where the on-disk path is for the mountpoint and register it
     FString PathOnDisk = FPaths::ProjectDir() / MountPoint;
-    FPackageName::RegisterMountPoint(MountPoint, PathOnDisk);
 
     FString MountPointFull = PathOnDisk;
     FPaths::MakeStandardFilename(MountPointFull);
 
-    LOG("Mounting at %s and registering mount point %s at %s", *MountPointFull, *MountPoint, *PathOnDisk);
-    if (PakFileMgr->Mount(*pakPath, 0, *MountPointFull))
+    if (!MountedPaks.Contains(key))
     {
-        if (UAssetManager* Manager = UAssetManager::GetIfValid())
+        FPackageName::RegisterMountPoint(MountPoint, PathOnDisk);
+
+        LOG("Mounting at %s and registering mount point %s at %s", *MountPointFull, *MountPoint, *PathOnDisk);
+        if (!PakFileMgr->Mount(*pakPath, 0, *MountPointFull))
         {
-            Manager->GetAssetRegistry().SearchAllAssets(true);
-            if (bLoadContent)
-            {
-                TArray<FString> FileList;
-                PakFile.FindFilesAtPath(FileList, *PakFile.GetMountPoint(), true, false, true);
+            LOG("mount failed!", NULL);
+            FPackageName::UnRegisterMountPoint(MountPoint, PathOnDisk);
+            ret = -1; goto exit;
+        }
 
-                // Iterate over the collected files from the pak
-                for (auto asset : FileList)
-                {
-                    FString Package, BaseName, Extension;
-                    FPaths::Split(asset, Package, BaseName, Extension);
-                    FString ModifiedAssetName = Package / BaseName + "." + BaseName;
+        if (Prefetcher)
+            Prefetcher->Forget(requestedPath);
 
-                    LOG("Trying to load %s as %s ", *asset, *ModifiedAssetName);
-                    Manager->GetStreamableManager().LoadSynchronous(ModifiedAssetName, true, nullptr);
-                }
-            }
+        // Loaded objects are named by package, not by file
+        FString PackageRoot;
+        if (FPackageName::TryConvertFilenameToLongPackageName(MountPoint, PackageRoot))
+        {
+            if (!PackageRoot.EndsWith(T("/")))
+                PackageRoot += T("/");
         }
         else
         {
-            LOG("Asset manager not valid!", NULL);
-            ret = -1; goto exit;
+            LOG("Mount point %s is not under a content root", *MountPoint);
+            PackageRoot.Empty();
+        }
+
+        FMountedPak& pak = MountedPaks.Add(key);
+        pak.PakPath       = requestedPath;
+        pak.MountPoint    = MountPoint;
+        pak.PathOnDisk    = PathOnDisk;
+        pak.PackageRoot   = PackageRoot;
+        pak.ResidentBytes = 0;
+        pak.LastUse       = FPlatformTime::Seconds();
+    }
+
+    if (UAssetManager* Manager = UAssetManager::GetIfValid())
+    {
+        FMountedPak& pak = MountedPaks[key];
+
+        IAssetRegistry& Registry = Manager->GetAssetRegistry();
+
+        Registry.SearchAllAssets(true);
+        if (filter.bLoad)
+        {
+            TArray<FString> FileList;
+            PakFile.FindFilesAtPath(FileList, *PakFile.GetMountPoint(), true, false, true);
+
+            // Object path of every package in the pak, and those to load
+            TMap<FName, FString> PakPackages;
+            TArray<FName>        Selected;
+
+            for (auto asset : FileList)
+            {
+                FString Package, BaseName, Extension;
+                FPaths::Split(asset, Package, BaseName, Extension);
+                /*
+                 *  Loads, lookups and dependencies all use long package
+                 *  names; files outside of any content root are not
+                 *  packages and are skipped.
+                 */
+                FString PackageName;
+                if (!FPackageName::TryConvertFilenameToLongPackageName(Package / BaseName, PackageName))
+                    continue;
+                FName   PackageFName(*PackageName);
+                FString ObjectPath = PackageName + T(".") + BaseName;
+                PakPackages.Add(PackageFName, ObjectPath);
+
+                if (!filter.MatchesPath(asset))
+                    continue;
+
+                // The class is known to the registry without loading anything
+                if (!filter.MatchesClass(Registry.GetAssetByObjectPath(FName(*ObjectPath))))
+                    continue;
+
+                Selected.AddUnique(PackageFName);
+            }
+
+            /*
+             *  Load the selected packages and the packages of the pak they
+             *  depend on one dependency layer at a time, leaves first.  Each
+             *  layer is a single request whose packages load in parallel,
+             *  and anything shared has been loaded by the time its
+             *  dependents are.
+             */
+            TArray<TArray<FName>> Layers = dependency_layers(Registry, PakPackages, Selected);
+            TSet<FName>           SelectedSet(Selected);
+
+            for (int32 i = 0; i < Layers.Num(); i++)
+            {
+                TArray<FSoftObjectPath> Batch;
+                for (auto& pkg : Layers[i])
+                    Batch.Add(FSoftObjectPath(PakPackages[pkg]));
+
+                LOG("Loading dependency layer %d of %d (%d packages)", i + 1, Layers.Num(), Batch.Num());
+                TSharedPtr<FStreamableHandle> handle = Manager->GetStreamableManager().RequestAsyncLoad(
+                    Batch, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority, true);
+                if (handle.IsValid())
+                    handle->WaitUntilComplete();
+
+                for (auto& pkg : Layers[i])
+                {
+                    const FString& ObjectPath = PakPackages[pkg];
+                    UObject* obj = FSoftObjectPath(ObjectPath).ResolveObject();
+
+                    if (obj && SelectedSet.Contains(pkg) && !pak.Objects.Contains(ObjectPath))
+                    {
+                        gc_stats.LoadsSinceLast++;
+                        pak.Objects.Add(ObjectPath);
+                        pak.ResidentBytes += resident_bytes(obj);
+                    }
+                }
+            }
         }
     }
     else
     {
-        LOG("mount failed!", NULL);
+        LOG("Asset manager not valid!", NULL);
         ret = -1; goto exit;
     }
 
   exit:
-    // Restore the platform file
-    FPlatformFileManager::Get().SetPlatformFile(*originalPlatform);
+    if (ret == 0)
+        EnforcePakBudget(key);
 
     return ret;
 }
 
-UObject*
-URCHTTP::LoadObject(const FString& assetPath)
+/*
+ *  Allow the objects in `pkg` to be collected once nothing references them
+ *  and optionally detach the package from its loader, so that the file it
+ *  was loaded from can go away.  The objects that were standalone are
+ *  added to `cleared`, if given, so the flag can be restored on survivors.
+ */
+static void
+release_package(UPackage* pkg, bool bResetLoaders,
+                TArray<TWeakObjectPtr<UObject>>* cleared = nullptr)
 {
-    UObject* ret = nullptr;
-    IPlatformFile *originalPlatform = &FPlatformFileManager::Get().GetPlatformFile();
+    ForEachObjectWithOuter(pkg, [cleared](UObject* obj) {
+        if (!obj->HasAnyFlags(RF_Standalone))
+            return;
+        obj->ClearFlags(RF_Standalone);
+        if (cleared)
+            cleared->Add(obj);
+    }, true);
+
+    if (bResetLoaders)
+        ResetLoaders(pkg);
+}
 
-    if (PakFileMgr == nullptr)
+/*
+ *  Drop every hold the plugin has on the objects loaded from `Pak` so that
+ *  the next garbage collection is free to reclaim them.  When the pak is
+ *  about to be unmounted, `bResetLoaders` detaches the owning packages from
+ *  it so that any objects that survive no longer read from it.  Returns
+ *  weak references to the released objects so callers can tell which of
+ *  them are still referenced; every object whose standalone flag was
+ *  cleared is added to `cleared`, if given.
+ */
+TArray<TWeakObjectPtr<UObject>>
+URCHTTP::ReleasePakContent(FMountedPak& Pak, bool bResetLoaders,
+                           TArray<TWeakObjectPtr<UObject>>* cleared)
+{
+    TArray<TWeakObjectPtr<UObject>> released;
+    TSet<UPackage*> packages;
+    UAssetManager* Manager = UAssetManager::GetIfValid();
+
+    for (auto& path : Pak.Objects)
     {
-        LOG("Failed to create platform file %s", T("PakFile"));
-        return ret;
-    }
+        FSoftObjectPath ref(path);
+        if (Manager)
+            Manager->GetStreamableManager().Unload(ref);
 
-    // The pak reader is now the current platform file.
-    FPlatformFileManager::Get().SetPlatformFile(*PakFileMgr);
-    UAssetManager* Manager = UAssetManager::GetIfValid();
+        if (TSharedPtr<FStreamableHandle> handle = Handles.FindRef(path))
+        {
+            handle->ReleaseHandle();
+            Handles.Remove(path);
+        }
 
-    ret = FindObject<UStaticMesh>(ANY_PACKAGE, *assetPath);
-    if (Manager && ret == nullptr)
-        ret = Manager->GetStreamableManager().LoadSynchronous(assetPath, false, nullptr);
+        if (UObject* obj = ref.ResolveObject())
+        {
+            released.Add(obj);
+            packages.Add(obj->GetOutermost());
+        }
+    }
 
-    // Reset the platform file.
-    FPlatformFileManager::Get().SetPlatformFile(*originalPlatform);
+    for (auto pkg : packages)
+        release_package(pkg, bResetLoaders, cleared);
 
-    return ret;
+    Pak.ResidentBytes = 0;
+    return released;
 }
 
-/*
- *  TODO: Deprecate this function.
- */
 int
-URCHTTP::UnloadObject(const FString& assetPath)
+URCHTTP::UnmountPakFile(const FString& pakPath)
 {
-    GarbageCollect();
+    FString key = pak_key(ResolvePakPath(pakPath));
+    FMountedPak* pak = MountedPaks.Find(key);
+
+    if (pak == nullptr)
+    {
+        LOG("PakFile %s is not mounted", *pakPath);
+        return -1;
+    }
+
+    /*
+     *  Detach everything loaded from the pak first so that nothing still
+     *  reads from it.  If the pak cannot be unmounted it stays registered
+     *  and mounted, and its objects can simply be loaded again.
+     */
+    ReleasePakContent(*pak, true);
+
+    if (!PakFileMgr->Unmount(*ResolvePakPath(pak->PakPath)))
+    {
+        LOG("unmount of %s failed!", *pak->PakPath);
+        return -1;
+    }
+
+    // Forget the registry entries of everything we loaded from the pak
+    auto& AssetRegistry =
+        FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+    for (auto& path : pak->Objects)
+    {
+        if (UObject* obj = FSoftObjectPath(path).ResolveObject())
+            AssetRegistry.AssetDeleted(obj);
+    }
+
+    // Paks often share a content root; only drop a path nobody else uses
+    bool shared = pak->PackageRoot.Len() == 0;
+    for (auto& it : MountedPaks)
+    {
+        const FString& other = it.Value.PackageRoot;
+        if (it.Key != key && other.Len() > 0 &&
+            (other.StartsWith(pak->PackageRoot) || pak->PackageRoot.StartsWith(other)))
+            shared = true;
+    }
+    if (!shared)
+        AssetRegistry.RemovePath(pak->PackageRoot);
+
+    LOG("Unmounted %s and unregistering mount point %s", *pak->PakPath, *pak->MountPoint);
+    FPackageName::UnRegisterMountPoint(pak->MountPoint, pak->PathOnDisk);
+
+    MountedPaks.Remove(key);
     return 0;
 }
 
-void
-URCHTTP::GarbageCollect()
+bool
+URCHTTP::IsPakMounted(const FString& pakPath) const
 {
-    CollectGarbage(RF_NoFlags, true);
+    return MountedPaks.Contains(pak_key(ResolvePakPath(pakPath)));
 }
 
 void
-URCHTTP::FinishAllShaderCompilation()
+URCHTTP::SetPakCacheLimit(int64 bytes)
 {
-    if (GShaderCompilingManager)
-        GShaderCompilingManager->FinishAllCompilation();
+    HttpPakFile->SetCacheLimit(bytes);
 }
 
 void
-URCHTTP::GameRenderSync()
+URCHTTP::SetPakBudget(int64 bytes)
 {
-    static FFrameEndSync FrameEndSync;
-    /* Do a full sync without allowing a frame of lag */
-    FrameEndSync.Sync(false);
+    pak_budget = FMath::Max<int64>(bytes, 0);
+    EnforcePakBudget(FString());
 }
 
-////////////////////////////////////////////////////////////////////////////////
+/*
+ *  Mark the pak that `obj` was loaded from as recently used.  The pak is
+ *  the one with the most specific package root containing the object.
+ */
+void
+URCHTTP::TouchPak(UObject* obj)
+{
+    if (obj == nullptr)
+        return;
 
-// HTTP responses.
-const mg_str_t STATUS_OK              = mg_mk_str("OK\r\n");
-const mg_str_t STATUS_ERROR           = mg_mk_str("ERROR\r\n");
-const mg_str_t STATUS_TRY_AGAIN       = mg_mk_str("TRY AGAIN\r\n");
-const mg_str_t STATUS_NOT_SUPPORTED   = mg_mk_str("NOT SUPPORTED\r\n");
-const mg_str_t STATUS_NOT_IMPLEMENTED = mg_mk_str("NOT IMPLEMENTED\r\n");
-const mg_str_t STATUS_BAD_ACTION      = mg_mk_str("BAD ACTION\r\n");
-const mg_str_t STATUS_BAD_ENTITY      = mg_mk_str("BAD ENTITY\r\n");
+    FString      path  = obj->GetPathName();
+    FString      pkg   = obj->GetOutermost()->GetName();
+    FMountedPak* owner = nullptr;
+    for (auto& it : MountedPaks)
+    {
+        FMountedPak& pak = it.Value;
+        if (pak.PackageRoot.Len() == 0 || !pkg.StartsWith(pak.PackageRoot))
+            continue;
+        if (owner == nullptr || pak.PackageRoot.Len() > owner->PackageRoot.Len())
+            owner = &pak;
+    }
 
-// HTTP query responses.
-const mg_str_t STATUS_TRUE            = mg_mk_str("TRUE\r\n");
-const mg_str_t STATUS_FALSE           = mg_mk_str("FALSE\r\n");
+    if (owner == nullptr)
+        return;
 
-// Helper to match a list of URIs.
-template<typename... Strings> bool
-matches_any(mg_str_t* s, Strings... args)
-{
-    std::vector<std::string> items = {args...};
-    for (int i = 0; i < items.size(); i++)
-        if (mg_vcmp(s, items[i].c_str()) == 0)
-            return true;
-    return false;
+    owner->LastUse = FPlatformTime::Seconds();
+    if (!owner->Objects.Contains(path))
+    {
+        owner->Objects.Add(path);
+        owner->ResidentBytes += resident_bytes(obj);
+    }
 }
 
-////////////////////////////////////////////////////////////////////////////////
-
-static void
-ev_handler(struct mg_connection* conn, int ev, void *ev_data)
+/*
+ *  Evict least recently used paks until the resident content of all
+ *  mounted paks fits in `pak_budget`.  The content of each candidate is
+ *  released and collected in one pass; paks whose objects survive the
+ *  collection are still referenced by the scene and stay mounted, fully
+ *  intact.  Loaders are only reset for the paks that are unmounted.
+ */
+void
+URCHTTP::EnforcePakBudget(const FString& keep)
 {
-    if (ev != MG_EV_HTTP_REQUEST)
+    if (pak_budget <= 0)
         return;
 
-    http_message_t* msg       = (http_message_t *)ev_data;
-    mg_str_t        rspMsg    = STATUS_ERROR;
-    int             rspStatus = 404;
-    URCHTTP*        server    = URCHTTP::Get();
+    int64 total = 0;
+    for (auto& it : MountedPaks)
+        total += it.Value.ResidentBytes;
+    if (total <= pak_budget)
+        return;
 
-#if WITH_EDITOR
-    auto ar = "AssetRegistry";
-    FAssetRegistryModule& AssetRegistry =
-        FModuleManager::LoadModuleChecked<FAssetRegistryModule>(ar);
+    TArray<FString> order;
+    MountedPaks.GetKeys(order);
+    order.Sort([this](const FString& a, const FString& b) {
+        return MountedPaks[a].LastUse < MountedPaks[b].LastUse;
+    });
 
-    /*
-     *  HTTP GET commands
-     */
-    if (mg_vcmp(&msg->method, "GET") == 0)
+    struct FVictim
     {
-        /*
-         *  HTTP GET /
-         *
-         *  Return "OK"
-         */
-        if (matches_any(&msg->uri, "/"))
+        TArray<TWeakObjectPtr<UObject>> Released;
+        TArray<TWeakObjectPtr<UObject>> Cleared;
+    };
+
+    TMap<FString, FVictim> victims;
+    for (auto& key : order)
+    {
+        if (total <= pak_budget)
+            break;
+
+        FMountedPak& pak = MountedPaks[key];
+        if (key == keep || pak.ResidentBytes == 0)
+            continue;
+
+        total -= pak.ResidentBytes;
+        FVictim& victim = victims.Add(key);
+        victim.Released = ReleasePakContent(pak, false, &victim.Cleared);
+    }
+
+    if (victims.Num() == 0)
+        return;
+
+    GarbageCollect();
+
+    for (auto& it : victims)
+    {
+        FMountedPak& pak = MountedPaks[it.Key];
+        int alive = 0;
+        for (auto& obj : it.Value.Released)
         {
-            goto OK;
+            if (!obj.IsValid())
+                continue;
+            pak.ResidentBytes += resident_bytes(obj.Get());
+            alive++;
         }
 
-        /*
-         *  HTTP GET /play
-         *
-         *  Trigger a play in the current level.
-         */
-        else if (matches_any(&msg->uri, "/play", "/ue4/play"))
+        // Anything that was standalone and survived keeps the pak in use
+        for (auto& obj : it.Value.Cleared)
         {
-            GEditor->PlayMap(NULL, NULL, -1, -1, false);
-            goto OK;
+            if (!obj.IsValid())
+                continue;
+            obj->SetFlags(RF_Standalone);
+            alive = FMath::Max(alive, 1);
+        }
+
+        if (alive > 0)
+        {
+            LOG("PakFile %s still has %d referenced objects, keeping it mounted", *pak.PakPath, alive);
+            continue;
+        }
+
+        FString path = pak.PakPath;
+        LOG("Evicting PakFile %s to stay under budget", *path);
+        UnmountPakFile(path);
+    }
+}
+
+TSharedRef<FJsonObject>
+URCHTTP::GetMountedPaks() const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    TArray<TSharedPtr<FJsonValue>> paks;
+    double now = FPlatformTime::Seconds();
+
+    for (auto& it : MountedPaks)
+    {
+        TSharedRef<FJsonObject> pak = MakeShareable(new FJsonObject);
+        pak->SetStringField(T("pak_path"), it.Value.PakPath);
+        pak->SetStringField(T("mount_point"), it.Value.MountPoint);
+        pak->SetStringField(T("package_root"), it.Value.PackageRoot);
+        pak->SetNumberField(T("objects"), it.Value.Objects.Num());
+        pak->SetNumberField(T("resident_bytes"), it.Value.ResidentBytes);
+        pak->SetNumberField(T("idle_seconds"), now - it.Value.LastUse);
+        paks.Add(MakeShareable(new FJsonValueObject(pak)));
+    }
+
+    ret->SetNumberField(T("budget_bytes"), pak_budget);
+    ret->SetArrayField(T("paks"), paks);
+    return ret;
+}
+
+/*
+ *  Canonical form of an object path, used to key the object cache.  Any
+ *  surrounding whitespace and `Class'...'` wrapper are stripped, and a bare
+ *  package path gets its asset name appended.  The class named by the
+ *  wrapper, if any, is returned in `outClass`.
+ */
+static FString
+normalize_object_path(const FString& path, FString* outClass = nullptr)
+{
+    FString ret = path.TrimStartAndEnd();
+    FString cls, inner;
+
+    if (ret.EndsWith(T("'")) && ret.Split(T("'"), &cls, &inner))
+    {
+        ret = inner.LeftChop(1);
+        if (outClass)
+            *outClass = cls.TrimStartAndEnd();
+    }
+
+    if (ret.Len() > 0 && !FPaths::GetCleanFilename(ret).Contains(T(".")))
+        ret += T(".") + FPaths::GetCleanFilename(ret);
+
+    return ret;
+}
+
+/*
+ *  Look up an already loaded object by its fully qualified path.  The
+ *  package is found first and the object is then looked up within it, so
+ *  only the object hash buckets for those two names are searched.
+ */
+static UObject*
+find_loaded_object(UClass* cls, const FString& objectPath)
+{
+    FString pkgName, objName;
+
+    if (!objectPath.Split(T("."), &pkgName, &objName, ESearchCase::CaseSensitive, ESearchDir::FromEnd))
+        return nullptr;
+
+    // Sub-objects are nested in their asset, fall back to a path walk
+    if (objName.Contains(T(":")))
+        return StaticFindObject(cls, nullptr, *objectPath);
+
+    UPackage* pkg = FindObjectFast<UPackage>(nullptr, FName(*pkgName));
+    if (pkg == nullptr)
+        return nullptr;
+    return StaticFindObjectFast(cls, pkg, FName(*objName));
+}
+
+/*
+ *  True once an async load has finished with `obj`: it has been
+ *  serialized and post-loaded, and is no longer owned by the loader.
+ */
+static bool
+is_fully_loaded(UObject* obj)
+{
+    return obj != nullptr &&
+        !obj->HasAnyFlags(RF_NeedLoad | RF_NeedPostLoad) &&
+        !obj->HasAnyInternalFlags(EInternalObjectFlags::AsyncLoading);
+}
+
+/*
+ *  Resolve a class given either by its short name (`StaticMesh`) or its
+ *  full path (`/Script/Engine.StaticMesh`, `/Game/BP_Foo.BP_Foo_C`).  The
+ *  result is cached so each name is only ever searched for once.
+ */
+UClass*
+URCHTTP::ResolveClass(const FString& className)
+{
+    if (className.Len() == 0)
+        return UObject::StaticClass();
+
+    if (TWeakObjectPtr<UClass>* cached = ClassCache.Find(className))
+    {
+        if (cached->IsValid())
+            return cached->Get();
+    }
+
+    UClass* cls = nullptr;
+    if (className.Contains(T(".")))
+    {
+        cls = FindObject<UClass>(nullptr, *className);
+        if (cls == nullptr)
+            cls = ::LoadObject<UClass>(nullptr, *className);
+    }
+    else
+    {
+        cls = FindObject<UClass>(ANY_PACKAGE, *className);
+    }
+
+    if (cls == nullptr)
+        LOG("Unknown class %s", *className);
+    else
+        ClassCache.Add(className, cls);
+    return cls;
+}
+
+UObject*
+URCHTTP::LoadObject(const FString& assetPath, const FString& className)
+{
+    UObject* ret = nullptr;
+    FString pathClass;
+    FString objectPath = normalize_object_path(assetPath, &pathClass);
+    UClass* cls = ResolveClass(pathClass.Len() ? pathClass : className);
+
+    if (cls == nullptr)
+        return ret;
+
+    // Hot objects resolve without touching the global object table
+    if (TWeakObjectPtr<UObject>* cached = ObjectCache.Find(objectPath))
+    {
+        if (cached->IsValid())
+        {
+            ret = cached->Get();
+            TouchPak(ret);
+            if (ClaimPrefetched(objectPath))
+                ClaimObject(objectPath, ret);
+            return ret->IsA(cls) ? ret : nullptr;
+        }
+        ObjectCache.Remove(objectPath);
+    }
+
+    if (PakFileMgr == nullptr)
+    {
+        LOG("Failed to create platform file %s", T("PakFile"));
+        return ret;
+    }
+
+    UAssetManager* Manager = UAssetManager::GetIfValid();
+
+    // Objects that are still being loaded asynchronously are waited for
+    ret = find_loaded_object(cls, objectPath);
+    if (!is_fully_loaded(ret))
+        ret = nullptr;
+    if (Manager && ret == nullptr)
+    {
+        // A load of the object already in flight is joined by the
+        // streamable manager, without waiting for the rest of its batch
+        TSharedPtr<FStreamableHandle> handle =
+            Manager->GetStreamableManager().RequestSyncLoad(FSoftObjectPath(objectPath));
+        if (handle.IsValid() && handle->GetLoadedAsset() != nullptr)
+        {
+            ret = handle->GetLoadedAsset();
+            Handles.Add(objectPath, handle);
+            gc_stats.LoadsSinceLast++;
+        }
+    }
+    TouchPak(ret);
+
+    if (ret != nullptr)
+    {
+        ObjectCache.Add(objectPath, ret);
+        if (ClaimPrefetched(objectPath))
+            ClaimObject(objectPath, ret);
+    }
+
+    if (ret != nullptr && !ret->IsA(cls))
+    {
+        LOG("%s is a %s, not a %s", *objectPath, *ret->GetClass()->GetName(), *cls->GetName());
+        ret = nullptr;
+    }
+
+    return ret;
+}
+
+/*
+ *  The async load that `objectPath` is part of, if it is still in flight.
+ *  Loads of the same object join it instead of issuing their own.
+ */
+TSharedPtr<FStreamableHandle>
+URCHTTP::FindInFlightLoad(const FString& objectPath) const
+{
+    const TSharedPtr<FStreamableHandle>* handle = InFlightLoads.Find(objectPath);
+    if (handle != nullptr && (*handle)->IsLoadingInProgress())
+        return *handle;
+    return nullptr;
+}
+
+void
+URCHTTP::AddInFlightLoads(const TArray<FSoftObjectPath>& objectPaths,
+                          const TSharedPtr<FStreamableHandle>& handle)
+{
+    for (auto& objectPath : objectPaths)
+        InFlightLoads.Add(objectPath.ToString(), handle);
+}
+
+void
+URCHTTP::RemoveInFlightLoads(const TSharedPtr<FStreamableHandle>& handle)
+{
+    for (auto it = InFlightLoads.CreateIterator(); it; ++it)
+    {
+        if (it.Value() == handle || !it.Value()->IsLoadingInProgress())
+            it.RemoveCurrent();
+    }
+}
+
+/*
+ *  Hold a freshly loaded object with its own streamable handle, exactly as
+ *  if LoadObject had loaded it, so that UnloadObject can release it.
+ */
+void
+URCHTTP::ClaimObject(const FString& objectPath, UObject* obj)
+{
+    UAssetManager* Manager = UAssetManager::GetIfValid();
+    if (Manager && !Handles.Contains(objectPath))
+    {
+        // The object is resident, so this completes without loading
+        TSharedPtr<FStreamableHandle> handle =
+            Manager->GetStreamableManager().RequestSyncLoad(FSoftObjectPath(objectPath));
+        if (handle.IsValid())
+            Handles.Add(objectPath, handle);
+    }
+    ObjectCache.Add(objectPath, obj);
+    TouchPak(obj);
+}
+
+/*
+ *  Objects that are already resident are resolved straight away and the
+ *  rest are loaded by one async request.  The returned job completes once
+ *  that request has, with the status and load time of every object; load
+ *  times are measured to the tick in which the object was seen loaded.
+ */
+int32
+URCHTTP::LoadObjects(const TArray<FString>& objectPaths, const FString& className)
+{
+    TSharedRef<TArray<FLoadItem>> items = MakeShareable(new TArray<FLoadItem>);
+    TArray<FSoftObjectPath> requests;
+    TSet<FString>           requested;
+    double                  started = FPlatformTime::Seconds();
+    int32                   joined  = 0;
+
+    for (auto& path : objectPaths)
+    {
+        FString pathClass;
+        FLoadItem item;
+        item.Path       = path;
+        item.ObjectPath = normalize_object_path(path, &pathClass);
+        item.Class      = ResolveClass(pathClass.Len() ? pathClass : className);
+        item.Status     = T("pending");
+        item.LoadMs     = 0.0;
+        item.bCoalesced = false;
+
+        UObject* obj = nullptr;
+        if (item.Class == nullptr)
+        {
+            item.Status = T("failed");
+        }
+        else if (TWeakObjectPtr<UObject>* cached = ObjectCache.Find(item.ObjectPath))
+        {
+            obj = cached->Get();
+        }
+
+        if (item.Class != nullptr && obj == nullptr)
+            obj = find_loaded_object(UObject::StaticClass(), item.ObjectPath);
+
+        if (item.Class == nullptr)
+        {
+            // Unknown class, already reported
+        }
+        else if (is_fully_loaded(obj))
+        {
+            item.Status = obj->IsA(item.Class) ? T("resident") : T("failed");
+            ObjectCache.Add(item.ObjectPath, obj);
+            TouchPak(obj);
+            if (ClaimPrefetched(item.ObjectPath))
+                ClaimObject(item.ObjectPath, obj);
+        }
+        else if (!requested.Contains(item.ObjectPath))
+        {
+            // Objects another load has in flight are requested again; the
+            // streamable manager joins that load, so this batch does not
+            // wait for the rest of the other one
+            item.bCoalesced = FindInFlightLoad(item.ObjectPath).IsValid();
+            joined += item.bCoalesced ? 1 : 0;
+            requested.Add(item.ObjectPath);
+            requests.Add(FSoftObjectPath(item.ObjectPath));
+        }
+        items->Add(item);
+    }
+
+    TSharedPtr<FStreamableHandle> handle;
+    UAssetManager* Manager = UAssetManager::GetIfValid();
+    if (Manager && requests.Num() > 0)
+    {
+        handle = Manager->GetStreamableManager().RequestAsyncLoad(
+            requests, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+        if (handle.IsValid())
+            AddInFlightLoads(requests, handle);
+    }
+
+    LOG("Loading %d objects, %d of them asynchronously and %d with loads in flight",
+        items->Num(), requests.Num(), joined);
+
+    return StartJob(T("loadobj"), [this, items, handle, started](FOrcJob& job) mutable -> bool
+    {
+        double now  = FPlatformTime::Seconds();
+        bool   done = !handle.IsValid() || !handle->IsLoadingInProgress();
+
+        for (auto& item : *items)
+        {
+            if (item.Status != T("pending"))
+                continue;
+
+            UObject* obj = find_loaded_object(UObject::StaticClass(), item.ObjectPath);
+            if (is_fully_loaded(obj) || done)
+            {
+                item.Status = T("loaded");
+                item.LoadMs = (now - started) * 1000.0;
+            }
+        }
+
+        if (!done)
+            return false;
+
+        // Each object is now held by a handle of its own
+        if (handle.IsValid())
+        {
+            RemoveInFlightLoads(handle);
+            handle->ReleaseHandle();
+            handle.Reset();
+        }
+
+        TArray<TSharedPtr<FJsonValue>> objects;
+        int32 counts[3] = { 0, 0, 0 };
+        int32 coalesced = 0;
+        for (auto& item : *items)
+        {
+            if (item.Status == T("loaded"))
+            {
+                UObject* obj = find_loaded_object(UObject::StaticClass(), item.ObjectPath);
+                if (obj != nullptr && obj->IsA(item.Class))
+                {
+                    ClaimObject(item.ObjectPath, obj);
+                    ClaimPrefetched(item.ObjectPath);
+                    gc_stats.LoadsSinceLast++;
+                }
+                else
+                {
+                    item.Status = T("failed");
+                }
+            }
+
+            counts[item.Status == T("resident") ? 0 : item.Status == T("loaded") ? 1 : 2]++;
+
+            TSharedRef<FJsonObject> obj = MakeShareable(new FJsonObject);
+            obj->SetStringField(T("path"), item.Path);
+            obj->SetStringField(T("status"), item.Status);
+            obj->SetNumberField(T("load_ms"), item.LoadMs);
+            if (item.Status != T("failed"))
+            {
+                if (UObject* loaded = find_loaded_object(item.Class, item.ObjectPath))
+                    obj->SetObjectField(T("object"), DescribeObject(loaded));
+            }
+            if (item.bCoalesced)
+            {
+                obj->SetBoolField(T("coalesced"), true);
+                coalesced++;
+            }
+            objects.Add(MakeShareable(new FJsonValueObject(obj)));
+        }
+
+        job.Result = MakeShareable(new FJsonObject);
+        job.Result->SetNumberField(T("resident"), counts[0]);
+        job.Result->SetNumberField(T("loaded"), counts[1]);
+        job.Result->SetNumberField(T("failed"), counts[2]);
+        job.Result->SetNumberField(T("coalesced"), coalesced);
+        job.Result->SetArrayField(T("objects"), objects);
+        job.State = counts[2] > 0 ? T("failed") : T("done");
+        return true;
+    });
+}
+
+// Prefetches yield to every other async load.
+static const TAsyncLoadPriority PREFETCH_LOAD_PRIORITY = TNumericLimits<TAsyncLoadPriority>::Lowest();
+
+/*
+ *  Start loading objects that will be asked for soon, behind any other
+ *  load.  They are held until `ttlS` seconds from now unless /loadobj
+ *  claims them first.  Returns JSON describing what was queued.
+ */
+TSharedRef<FJsonObject>
+URCHTTP::PrefetchObjects(const TArray<FString>& objectPaths, double ttlS)
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    TSharedPtr<FObjectPrefetch> prefetch = MakeShareable(new FObjectPrefetch);
+    TArray<FSoftObjectPath> requests;
+    int32 resident = 0;
+
+    for (auto& path : objectPaths)
+    {
+        FString objectPath = normalize_object_path(path);
+        if (Handles.Contains(objectPath) || PrefetchedObjects.Contains(objectPath) ||
+            prefetch->Unclaimed.Contains(objectPath) || FindInFlightLoad(objectPath).IsValid())
+        {
+            resident++;
+            continue;
+        }
+
+        prefetch->Unclaimed.Add(objectPath);
+        requests.Add(FSoftObjectPath(objectPath));
+    }
+
+    UAssetManager* Manager = UAssetManager::GetIfValid();
+    if (Manager && requests.Num() > 0)
+    {
+        prefetch->Handle = Manager->GetStreamableManager().RequestAsyncLoad(
+            requests, FStreamableDelegate(), PREFETCH_LOAD_PRIORITY);
+        prefetch->Expires  = FPlatformTime::Seconds() + ttlS;
+        prefetch->bLoading = prefetch->Handle.IsValid();
+
+        if (prefetch->bLoading)
+        {
+            AddInFlightLoads(requests, prefetch->Handle);
+            for (auto& objectPath : prefetch->Unclaimed)
+                PrefetchedObjects.Add(objectPath, prefetch);
+            ObjectPrefetches.Add(prefetch);
+        }
+        else
+            requests.Reset();
+    }
+    else
+    {
+        requests.Reset();
+    }
+
+    ret->SetNumberField(T("queued"), requests.Num());
+    ret->SetNumberField(T("skipped"), resident);
+    ret->SetNumberField(T("ttl_s"), ttlS);
+    return ret;
+}
+
+/*
+ *  Called when an object is loaded by /loadobj.  If it was prefetched, the
+ *  prefetch no longer needs to hold it; the caller takes over.  Returns
+ *  true in that case.
+ */
+bool
+URCHTTP::ClaimPrefetched(const FString& objectPath)
+{
+    TSharedPtr<FObjectPrefetch> prefetch;
+    if (!PrefetchedObjects.RemoveAndCopyValue(objectPath, prefetch))
+        return false;
+
+    prefetch_hits++;
+    prefetch->Unclaimed.Remove(objectPath);
+    if (prefetch->Unclaimed.Num() == 0)
+        prefetch->Expires = 0.0;    // Released on the next tick
+    return true;
+}
+
+/*
+ *  Release prefetches that were fully claimed or have expired.
+ */
+void
+URCHTTP::TickObjectPrefetches()
+{
+    double now = FPlatformTime::Seconds();
+
+    for (int32 i = 0; i < ObjectPrefetches.Num(); )
+    {
+        FObjectPrefetch& prefetch = *ObjectPrefetches[i];
+        bool complete = prefetch.Handle->HasLoadCompleted() || prefetch.Handle->WasCanceled();
+
+        if (prefetch.bLoading && complete)
+        {
+            prefetch.bLoading = false;
+            RemoveInFlightLoads(prefetch.Handle);
+        }
+
+        if (now < prefetch.Expires)
+        {
+            i++;
+            continue;
+        }
+
+        if (prefetch.Unclaimed.Num() > 0)
+        {
+            LOG("Prefetch of %d objects expired unclaimed", prefetch.Unclaimed.Num());
+            prefetch_expired += prefetch.Unclaimed.Num();
+        }
+
+        for (auto& objectPath : prefetch.Unclaimed)
+            PrefetchedObjects.Remove(objectPath);
+
+        if (complete)
+            prefetch.Handle->ReleaseHandle();
+        else
+            prefetch.Handle->CancelHandle();
+
+        if (prefetch.bLoading)
+            RemoveInFlightLoads(prefetch.Handle);
+
+        ObjectPrefetches.RemoveAt(i);
+    }
+}
+
+TSharedRef<FJsonObject>
+URCHTTP::GetObjectPrefetchStatus() const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    int32 loading = 0;
+
+    for (auto& prefetch : ObjectPrefetches)
+    {
+        if (prefetch->bLoading)
+            loading++;
+    }
+
+    ret->SetNumberField(T("requests"), ObjectPrefetches.Num());
+    ret->SetNumberField(T("loading"), loading);
+    ret->SetNumberField(T("unclaimed"), PrefetchedObjects.Num());
+    ret->SetNumberField(T("claimed"), prefetch_hits);
+    ret->SetNumberField(T("expired"), prefetch_expired);
+    return ret;
+}
+
+/*
+ *  Drop object cache entries for objects that did not survive the
+ *  collection.
+ */
+void
+URCHTTP::OnPostGarbageCollect()
+{
+    for (auto it = ObjectCache.CreateIterator(); it; ++it)
+    {
+        if (!it.Value().IsValid())
+            it.RemoveCurrent();
+    }
+
+    for (auto it = Descriptors.CreateIterator(); it; ++it)
+    {
+        if (!it.Value().Object.IsValid())
+            it.RemoveCurrent();
+    }
+}
+
+static TArray<TSharedPtr<FJsonValue>>
+vector_to_json(const FVector& v)
+{
+    TArray<TSharedPtr<FJsonValue>> ret;
+    ret.Add(MakeShareable(new FJsonValueNumber(v.X)));
+    ret.Add(MakeShareable(new FJsonValueNumber(v.Y)));
+    ret.Add(MakeShareable(new FJsonValueNumber(v.Z)));
+    return ret;
+}
+
+static TSharedRef<FJsonObject>
+bounds_to_json(const FBoxSphereBounds& bounds)
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    ret->SetArrayField(T("origin"), vector_to_json(bounds.Origin));
+    ret->SetArrayField(T("extent"), vector_to_json(bounds.BoxExtent));
+    ret->SetNumberField(T("radius"), bounds.SphereRadius);
+    return ret;
+}
+
+static TArray<TSharedPtr<FJsonValue>>
+names_to_json(const TArray<FName>& names)
+{
+    TArray<TSharedPtr<FJsonValue>> ret;
+    for (auto& name : names)
+        ret.Add(MakeShareable(new FJsonValueString(name.ToString())));
+    return ret;
+}
+
+/*
+ *  Describe a loaded object with the properties clients need to place it
+ *  in a scene: its class and memory footprint for every object, plus
+ *  bounds, triangle and vertex counts and material slots for meshes and
+ *  the size of textures.  Descriptors are computed once per object.
+ */
+TSharedRef<FJsonObject>
+URCHTTP::DescribeObject(UObject* obj)
+{
+    FString key = obj->GetPathName();
+    if (FObjectDescriptor* found = Descriptors.Find(key))
+    {
+        if (found->Object.Get() == obj)
+            return found->Json.ToSharedRef();
+    }
+
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    ret->SetStringField(T("path"), key);
+    ret->SetStringField(T("class"), obj->GetClass()->GetName());
+    ret->SetNumberField(T("resource_bytes"), resident_bytes(obj));
+
+    if (UStaticMesh* mesh = Cast<UStaticMesh>(obj))
+    {
+        TArray<FName> slots;
+        for (auto& material : mesh->StaticMaterials)
+            slots.Add(material.MaterialSlotName);
+
+        ret->SetObjectField(T("bounds"), bounds_to_json(mesh->GetBounds()));
+        ret->SetArrayField(T("material_slots"), names_to_json(slots));
+        ret->SetNumberField(T("lods"), mesh->GetNumLODs());
+        if (mesh->RenderData.IsValid() && mesh->RenderData->LODResources.Num() > 0)
+        {
+            const FStaticMeshLODResources& lod = mesh->RenderData->LODResources[0];
+            ret->SetNumberField(T("triangles"), lod.GetNumTriangles());
+            ret->SetNumberField(T("vertices"), lod.GetNumVertices());
+        }
+    }
+    else if (USkeletalMesh* mesh = Cast<USkeletalMesh>(obj))
+    {
+        TArray<FName> slots;
+        for (auto& material : mesh->Materials)
+            slots.Add(material.MaterialSlotName);
+
+        ret->SetObjectField(T("bounds"), bounds_to_json(mesh->GetBounds()));
+        ret->SetArrayField(T("material_slots"), names_to_json(slots));
+
+        FSkeletalMeshResource* resource = mesh->GetResourceForRendering();
+        if (resource != nullptr && resource->LODModels.Num() > 0)
+        {
+            const FStaticLODModel& lod = resource->LODModels[0];
+            ret->SetNumberField(T("lods"), resource->LODModels.Num());
+            ret->SetNumberField(T("triangles"), lod.GetTotalFaces());
+            ret->SetNumberField(T("vertices"), lod.NumVertices);
+        }
+    }
+    else if (UTexture2D* texture = Cast<UTexture2D>(obj))
+    {
+        ret->SetNumberField(T("width"), texture->GetSizeX());
+        ret->SetNumberField(T("height"), texture->GetSizeY());
+        ret->SetNumberField(T("mips"), texture->GetNumMips());
+    }
+
+    FObjectDescriptor& descriptor = Descriptors.Add(key);
+    descriptor.Object = obj;
+    descriptor.Json   = ret;
+    return ret;
+}
+
+/*
+ *  Release the plugin's hold on an object so that it can be collected.  The
+ *  streamable handle LoadObject created for it is released, and the objects
+ *  in its package lose their standalone flag.  If `bResetLoaders` is set the
+ *  package is also detached from its loader.  Nothing is collected here;
+ *  callers batch unloads and then collect once (see RequestGarbageCollect).
+ */
+int
+URCHTTP::UnloadObject(const FString& assetPath, bool bResetLoaders)
+{
+    FString objectPath = normalize_object_path(assetPath);
+    UObject* obj = find_loaded_object(UObject::StaticClass(), objectPath);
+
+    TSharedPtr<FStreamableHandle> handle;
+    if (Handles.RemoveAndCopyValue(objectPath, handle))
+        handle->ReleaseHandle();
+
+    if (UAssetManager* Manager = UAssetManager::GetIfValid())
+        Manager->GetStreamableManager().Unload(FSoftObjectPath(objectPath));
+
+    ObjectCache.Remove(objectPath);
+
+    if (obj == nullptr)
+    {
+        if (!handle.IsValid())
+        {
+            LOG("%s is not loaded", *objectPath);
+            return -1;
+        }
+        return 0;
+    }
+
+    release_package(obj->GetOutermost(), bResetLoaders);
+    return 0;
+}
+
+/*
+ *  Collect garbage at the end of the current tick.  Any number of requests
+ *  made during a tick result in a single collection.
+ */
+void
+URCHTTP::RequestGarbageCollect()
+{
+    gc_pending = true;
+}
+
+static uint64
+used_physical()
+{
+    return FPlatformMemory::GetStats().UsedPhysical;
+}
+
+void
+URCHTTP::GarbageCollect()
+{
+    // Finish and record a running incremental purge before starting over
+    if (gc_progress.bPurging)
+    {
+        double start = FPlatformTime::Seconds();
+        IncrementalPurgeGarbage(false);
+        gc_progress.BusyMs += (FPlatformTime::Seconds() - start) * 1000.0;
+        gc_progress.Frames++;
+        gc_progress.bPurging = false;
+        RecordGarbageCollect();
+    }
+
+    gc_progress.Started       = FPlatformTime::Seconds();
+    gc_progress.Frames        = 0;
+    gc_progress.ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+    gc_progress.RssBefore     = used_physical();
+
+    CollectGarbage(RF_NoFlags, true);
+
+    gc_progress.BusyMs = (FPlatformTime::Seconds() - gc_progress.Started) * 1000.0;
+    RecordGarbageCollect();
+}
+
+/*
+ *  Run the mark phase now and leave purging the unreachable objects to
+ *  subsequent ticks, each of which spends at most `budgetMs` on it.
+ */
+void
+URCHTTP::StartIncrementalGarbageCollect(float budgetMs)
+{
+    if (gc_progress.bPurging)
+        return;
+
+    gc_progress.bPurging      = true;
+    gc_progress.BudgetMs      = FMath::Max(budgetMs, 0.1f);
+    gc_progress.Started       = FPlatformTime::Seconds();
+    gc_progress.Frames        = 0;
+    gc_progress.ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+    gc_progress.RssBefore     = used_physical();
+
+    CollectGarbage(RF_NoFlags, false);
+
+    gc_progress.BusyMs = (FPlatformTime::Seconds() - gc_progress.Started) * 1000.0;
+}
+
+void
+URCHTTP::TickIncrementalGarbageCollect()
+{
+    if (!gc_progress.bPurging)
+        return;
+
+    if (IsIncrementalPurgePending())
+    {
+        double start = FPlatformTime::Seconds();
+        IncrementalPurgeGarbage(true, gc_progress.BudgetMs / 1000.0f);
+        gc_progress.BusyMs += (FPlatformTime::Seconds() - start) * 1000.0;
+        gc_progress.Frames++;
+        return;
+    }
+
+    gc_progress.bPurging = false;
+    RecordGarbageCollect();
+}
+
+/*
+ *  Fold the collection described by `gc_progress`, which just finished,
+ *  into the telemetry.
+ */
+void
+URCHTTP::RecordGarbageCollect()
+{
+    int32  objects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+    uint64 rss     = used_physical();
+
+    gc_stats.Count++;
+    gc_stats.LastTime         = FPlatformTime::Seconds();
+    gc_stats.LastDurationMs   = gc_progress.BusyMs;
+    gc_stats.TotalDurationMs += gc_progress.BusyMs;
+    gc_stats.LastObjectsFreed = gc_progress.ObjectsBefore - objects;
+    gc_stats.LastBytesFreed   = (int64)gc_progress.RssBefore - (int64)rss;
+    gc_stats.LoadsSinceLast   = 0;
+
+    LOG("Garbage collection (%s) freed %d objects and %lld bytes in %.1fms over %d frames",
+        *gc_stats.LastReason, gc_stats.LastObjectsFreed, gc_stats.LastBytesFreed,
+        gc_stats.LastDurationMs, gc_progress.Frames);
+    gc_stats.LastReason = T("request");
+}
+
+/*
+ *  Collect garbage on behalf of the client when memory runs high, many
+ *  objects have been loaded since the last collection, or it has simply
+ *  been a while.  Only called on ticks that handled no requests.
+ */
+void
+URCHTTP::TickGarbageCollectScheduler()
+{
+    const FGCScheduler& cfg = gc_scheduler;
+    double now = FPlatformTime::Seconds();
+
+    if (!cfg.bEnabled || gc_progress.bPurging || gc_pending)
+        return;
+    if (now - gc_scheduler_checked < 0.25)
+        return;
+    gc_scheduler_checked = now;
+
+    double since = now - FMath::Max(gc_stats.LastTime, gc_progress.Started);
+    if (since < cfg.MinIntervalS)
+        return;
+
+    const TCHAR* reason = nullptr;
+    if (cfg.RssBytes > 0 && used_physical() >= (uint64)cfg.RssBytes)
+        reason = T("rss");
+    else if (cfg.UObjects > 0 && GUObjectArray.GetObjectArrayNumMinusAvailable() >= cfg.UObjects)
+        reason = T("uobjects");
+    else if (cfg.Loads > 0 && gc_stats.LoadsSinceLast >= cfg.Loads)
+        reason = T("loads");
+    else if (cfg.MaxIntervalS > 0 && since >= cfg.MaxIntervalS && gc_stats.LoadsSinceLast > 0)
+        reason = T("interval");
+
+    if (reason == nullptr)
+        return;
+
+    gc_stats.LastReason = reason;
+    if (cfg.bIncremental)
+        StartIncrementalGarbageCollect(cfg.BudgetMs);
+    else
+        GarbageCollect();
+}
+
+void
+URCHTTP::ConfigureGarbageCollectScheduler(const TSharedPtr<FJsonObject>& json)
+{
+    FGCScheduler& cfg = gc_scheduler;
+    double mb;
+
+    json->TryGetBoolField(T("enabled"), cfg.bEnabled);
+    json->TryGetBoolField(T("incremental"), cfg.bIncremental);
+    json->TryGetNumberField(T("budget_ms"), cfg.BudgetMs);
+    json->TryGetNumberField(T("uobjects"), cfg.UObjects);
+    json->TryGetNumberField(T("loads"), cfg.Loads);
+    json->TryGetNumberField(T("min_interval_s"), cfg.MinIntervalS);
+    json->TryGetNumberField(T("max_interval_s"), cfg.MaxIntervalS);
+    if (json->TryGetNumberField(T("rss_mb"), mb))
+        cfg.RssBytes = (int64)(mb * 1024 * 1024);
+}
+
+TSharedRef<FJsonObject>
+URCHTTP::GetGarbageCollectStatus() const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    int32 objects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+
+    ret->SetStringField(T("state"), gc_progress.bPurging ? T("purging") : T("idle"));
+    ret->SetNumberField(T("objects"), objects);
+    ret->SetNumberField(T("rss_bytes"), used_physical());
+    if (gc_progress.bPurging)
+    {
+        ret->SetNumberField(T("budget_ms"), gc_progress.BudgetMs);
+        ret->SetNumberField(T("frames"), gc_progress.Frames);
+        ret->SetNumberField(T("elapsed_ms"), (FPlatformTime::Seconds() - gc_progress.Started) * 1000.0);
+        ret->SetNumberField(T("objects_freed"), gc_progress.ObjectsBefore - objects);
+    }
+
+    TSharedRef<FJsonObject> stats = MakeShareable(new FJsonObject);
+    stats->SetNumberField(T("count"), gc_stats.Count);
+    stats->SetNumberField(T("total_ms"), gc_stats.TotalDurationMs);
+    stats->SetNumberField(T("loads_since_last"), gc_stats.LoadsSinceLast);
+    if (gc_stats.Count > 0)
+    {
+        stats->SetStringField(T("last_reason"), gc_stats.LastReason);
+        stats->SetNumberField(T("last_ms"), gc_stats.LastDurationMs);
+        stats->SetNumberField(T("last_objects_freed"), gc_stats.LastObjectsFreed);
+        stats->SetNumberField(T("last_bytes_freed"), gc_stats.LastBytesFreed);
+        stats->SetNumberField(T("seconds_since_last"), FPlatformTime::Seconds() - gc_stats.LastTime);
+    }
+    ret->SetObjectField(T("telemetry"), stats);
+
+    const FGCScheduler& cfg = gc_scheduler;
+    TSharedRef<FJsonObject> sched = MakeShareable(new FJsonObject);
+    sched->SetBoolField(T("enabled"), cfg.bEnabled);
+    sched->SetBoolField(T("incremental"), cfg.bIncremental);
+    sched->SetNumberField(T("budget_ms"), cfg.BudgetMs);
+    sched->SetNumberField(T("rss_mb"), cfg.RssBytes / (1024.0 * 1024.0));
+    sched->SetNumberField(T("uobjects"), cfg.UObjects);
+    sched->SetNumberField(T("loads"), cfg.Loads);
+    sched->SetNumberField(T("min_interval_s"), cfg.MinIntervalS);
+    sched->SetNumberField(T("max_interval_s"), cfg.MaxIntervalS);
+    ret->SetObjectField(T("scheduler"), sched);
+    return ret;
+}
+
+void
+URCHTTP::FinishAllShaderCompilation()
+{
+    if (GShaderCompilingManager)
+        GShaderCompilingManager->FinishAllCompilation();
+}
+
+// Materials listed by GetShaderCompileStatus at most.
+static const int32 MAX_SHADER_STATUS_MATERIALS = 100;
+
+bool
+URCHTTP::IsCompilingShaders() const
+{
+    return GShaderCompilingManager != nullptr && GShaderCompilingManager->IsCompiling();
+}
+
+/*
+ *  Describe the outstanding shader compile jobs and the loaded materials
+ *  whose shader map for the current feature level is still compiling,
+ *  without waiting for anything.
+ */
+TSharedRef<FJsonObject>
+URCHTTP::GetShaderCompileStatus() const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    TArray<TSharedPtr<FJsonValue>> materials;
+    int32 pending = 0;
+
+    ret->SetBoolField(T("compiling"), IsCompilingShaders());
+    ret->SetNumberField(T("jobs"), GShaderCompilingManager ? GShaderCompilingManager->GetNumRemainingJobs() : 0);
+
+    for (TObjectIterator<UMaterialInterface> it; it; ++it)
+    {
+        FMaterialResource* resource = it->GetMaterialResource(GMaxRHIFeatureLevel);
+        if (resource == nullptr || resource->IsCompilationFinished())
+            continue;
+
+        if (pending++ < MAX_SHADER_STATUS_MATERIALS)
+            materials.Add(MakeShareable(new FJsonValueString(it->GetPathName())));
+    }
+
+    ret->SetNumberField(T("pending_materials"), pending);
+    ret->SetArrayField(T("materials"), materials);
+    return ret;
+}
+
+/*
+ *  Load the materials of a mounted pak in the background so that their
+ *  shader maps for the current feature level are compiled before anything
+ *  using them is rendered.  Returns the id of the job that tracks the
+ *  compilation, or -1 if the pak is not mounted.
+ */
+int32
+URCHTTP::WarmPakShaders(const FString& pakPath)
+{
+    FString key = pak_key(ResolvePakPath(pakPath));
+    FMountedPak* pak = MountedPaks.Find(key);
+    UAssetManager* Manager = UAssetManager::GetIfValid();
+
+    if (pak == nullptr || Manager == nullptr)
+    {
+        LOG("PakFile %s is not mounted", *pakPath);
+        return -1;
+    }
+
+    FString root = pak->PackageRoot;
+    FARFilter filter;
+    filter.ClassNames.Add(UMaterialInterface::StaticClass()->GetFName());
+    filter.bRecursivePaths   = true;
+    filter.bRecursiveClasses = true;
+
+    // The pak's content lives under the package path of its mount point
+    TArray<FAssetData> assets;
+    if (root.Len() > 0)
+    {
+        root.RemoveFromEnd(T("/"));
+        filter.PackagePaths.Add(FName(*root));
+        Manager->GetAssetRegistry().GetAssets(filter, assets);
+    }
+    else
+    {
+        LOG("No content path is registered for %s", *pak->MountPoint);
+    }
+
+    TArray<FSoftObjectPath> materials;
+    for (auto& asset : assets)
+        materials.Add(asset.ToSoftObjectPath());
+
+    // The pak owns the materials, so they are released when it is unmounted
+    TSharedPtr<FStreamableHandle> handle;
+    if (materials.Num() > 0)
+    {
+        handle = Manager->GetStreamableManager().RequestAsyncLoad(
+            materials, FStreamableDelegate(), FStreamableManager::DefaultAsyncLoadPriority, true);
+    }
+
+    LOG("Warming shaders for %d materials of %s", materials.Num(), *pakPath);
+
+    return StartJob(T("shaders"), [this, key, handle, materials](FOrcJob& job) mutable -> bool
+    {
+        job.Result = MakeShareable(new FJsonObject);
+        job.Result->SetNumberField(T("materials"), materials.Num());
+
+        if (handle.IsValid() && handle->IsLoadingInProgress())
+        {
+            job.Result->SetStringField(T("phase"), T("loading"));
+            return false;
+        }
+
+        if (handle.IsValid())
+        {
+            handle.Reset();
+
+            FMountedPak* pak = MountedPaks.Find(key);
+            for (auto& material : materials)
+            {
+                FString path = material.ToString();
+                UObject* obj = material.ResolveObject();
+                if (pak && obj && !pak->Objects.Contains(path))
+                {
+                    pak->Objects.Add(path);
+                    pak->ResidentBytes += resident_bytes(obj);
+                }
+            }
+        }
+
+        int32 compiled = 0, pending = 0, missing = 0;
+        for (auto& material : materials)
+        {
+            UMaterialInterface* obj = Cast<UMaterialInterface>(material.ResolveObject());
+            FMaterialResource*  resource = obj ? obj->GetMaterialResource(GMaxRHIFeatureLevel) : nullptr;
+
+            if (obj == nullptr)
+                missing++;
+            else if (resource == nullptr || resource->IsCompilationFinished())
+                compiled++;
+            else
+                pending++;
+        }
+
+        job.Result->SetStringField(T("phase"), pending > 0 ? T("compiling") : T("compiled"));
+        job.Result->SetNumberField(T("compiled"), compiled);
+        job.Result->SetNumberField(T("pending"), pending);
+        job.Result->SetNumberField(T("missing"), missing);
+
+        if (pending > 0)
+            return false;
+
+        job.State = missing > 0 ? T("failed") : T("done");
+        return true;
+    });
+}
+
+/*
+ *  Begin a render command fence in the current frame, unless one already
+ *  was, and return the frame's id.  The fence completes once the render
+ *  thread has processed everything the game thread enqueued so far.
+ */
+uint64
+URCHTTP::BeginFrameFence()
+{
+    uint64 frame = GFrameCounter;
+
+    if (!Fences.Contains(frame))
+    {
+        TSharedPtr<FRenderCommandFence> fence = MakeShareable(new FRenderCommandFence);
+        fence->BeginFence();
+        Fences.Add(frame, fence);
+    }
+    return frame;
+}
+
+/*
+ *  True once the render thread has passed frame `frame`.  A fence begun
+ *  during a frame completes before that frame's own rendering commands
+ *  are enqueued, so only one from a later frame will do; fences complete
+ *  in order, so any of them does.
+ */
+bool
+URCHTTP::IsFrameRendered(uint64 frame)
+{
+    if (frame < fence_rendered_frame)
+        return true;
+
+    for (auto& it : Fences)
+    {
+        if (it.Key > frame && it.Value->IsFenceComplete())
+            return true;
+    }
+    return false;
+}
+
+void
+URCHTTP::TickFences()
+{
+    for (auto it = Fences.CreateIterator(); it; ++it)
+    {
+        if (it.Value()->IsFenceComplete())
+        {
+            fence_rendered_frame = FMath::Max(fence_rendered_frame, it.Key());
+            it.RemoveCurrent();
+        }
+    }
+}
+
+// The world stepped by POST /step: the PIE world if playing.
+static UWorld*
+step_world()
+{
+#if WITH_EDITOR
+    if (GEditor && GEditor->PlayWorld)
+        return GEditor->PlayWorld;
+    if (GEditor)
+        return GEditor->GetEditorWorldContext().World();
+#endif
+    return GWorld;
+}
+
+/*
+ *  Advance the world by `frames` ticks of exactly `dt` seconds.  The first
+ *  step enters step mode: time advances in fixed steps without frame rate
+ *  smoothing or idle sleeps, and the world is paused between steps until
+ *  ReleaseStepMode.
+ *
+ *  With `bRender` the world is unpaused for `frames` engine frames, each of
+ *  which is rendered.  Otherwise the ticks are run back to back at the end
+ *  of the current frame, without rendering.  Returns -1 if a step is still
+ *  in progress.
+ */
+int
+URCHTTP::StartStep(int32 frames, float dt, bool bRender)
+{
+#if WITH_EDITOR
+    // The editor world does not run game ticks, so only PIE can be stepped
+    if (GEditor == nullptr || GEditor->PlayWorld == nullptr)
+    {
+        LOG("Unable to step: not playing in editor", NULL);
+        return -1;
+    }
+#endif
+
+    UWorld* world = step_world();
+    if (world == nullptr || step.Pending > 0 || frames <= 0 || dt <= 0.0f)
+        return -1;
+
+    if (!step.bActive || step.World.Get() != world)
+    {
+        if (step.bActive)
+            ReleaseStepMode();
+
+        step.bActive              = true;
+        step.World                = world;
+        step.bPrevFixedTimeStep   = FApp::UseFixedTimeStep();
+        step.PrevFixedDeltaTime   = FApp::GetFixedDeltaTime();
+        step.bPrevSmoothFrameRate = GEngine->bSmoothFrameRate;
+        step.bPrevPaused          = world->bDebugPauseExecution;
+
+        GEngine->bSmoothFrameRate = false;
+        LOG("Entering step mode for %s", *world->GetName());
+    }
+
+    FApp::SetUseFixedTimeStep(true);
+    FApp::SetFixedDeltaTime(dt);
+
+    step.bRender      = bRender;
+    step.DeltaSeconds = dt;
+    step.Frames       = frames;
+    step.Pending      = frames;
+    step.StartFrame   = GFrameCounter;
+    step.Started      = FPlatformTime::Seconds();
+    step.Finished     = 0.0;
+
+    world->bDebugPauseExecution = !bRender;
+    return 0;
+}
+
+/*
+ *  Count down the frames of a rendered step, pausing the world again once
+ *  they have all been ticked.  The frame the step was started in does not
+ *  count: the world had already ticked in it, paused.  Step mode is left
+ *  as soon as the stepped world goes away, e.g. when PIE ends.
+ */
+void
+URCHTTP::TickStepMode()
+{
+    if (!step.bActive)
+        return;
+
+    UWorld* world = step.World.Get();
+    if (world == nullptr)
+    {
+        LOG("The stepped world is gone", NULL);
+        ReleaseStepMode();
+        return;
+    }
+
+    if (!step.bRender || step.Pending == 0 || GFrameCounter <= step.StartFrame)
+        return;
+
+    if (--step.Pending == 0)
+    {
+        world->bDebugPauseExecution = true;
+        step.Finished = FPlatformTime::Seconds();
+    }
+}
+
+/*
+ *  Run the ticks of an unrendered step back to back.  This happens at the
+ *  end of the engine frame, outside of any world's tick.
+ */
+void
+URCHTTP::OnEndFrame()
+{
+    if (!step.bActive || step.bRender || step.Pending == 0)
+        return;
+
+    UWorld* world = step.World.Get();
+    if (world == nullptr)
+    {
+        ReleaseStepMode();
+        return;
+    }
+
+#if WITH_EDITOR
+    UWorld* previous = GEditor->PlayWorld == world ? GEditor->SetPlayInEditorWorld(world) : nullptr;
+#endif
+
+    world->bDebugPauseExecution = false;
+    for (; step.Pending > 0; step.Pending--)
+    {
+        FApp::SetDeltaTime(step.DeltaSeconds);
+        FApp::SetCurrentTime(FApp::GetCurrentTime() + step.DeltaSeconds);
+        world->Tick(LEVELTICK_All, step.DeltaSeconds);
+    }
+    world->bDebugPauseExecution = true;
+
+#if WITH_EDITOR
+    if (previous != nullptr)
+        GEditor->RestoreEditorWorld(previous);
+#endif
+
+    step.Finished = FPlatformTime::Seconds();
+}
+
+void
+URCHTTP::ReleaseStepMode()
+{
+    if (!step.bActive)
+        return;
+
+    if (UWorld* world = step.World.Get())
+        world->bDebugPauseExecution = step.bPrevPaused;
+
+    FApp::SetUseFixedTimeStep(step.bPrevFixedTimeStep);
+    FApp::SetFixedDeltaTime(step.PrevFixedDeltaTime);
+    GEngine->bSmoothFrameRate = step.bPrevSmoothFrameRate;
+
+    step = FStepMode();
+    LOG("Left step mode", NULL);
+}
+
+TSharedRef<FJsonObject>
+URCHTTP::GetStepStatus() const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    UWorld* world = step.World.Get();
+    double  end   = step.Pending > 0 ? FPlatformTime::Seconds() : step.Finished;
+
+    ret->SetBoolField(T("active"), step.bActive);
+    ret->SetNumberField(T("frames"), step.Frames - step.Pending);
+    ret->SetNumberField(T("pending"), step.Pending);
+    ret->SetNumberField(T("dt"), step.DeltaSeconds);
+    ret->SetNumberField(T("elapsed_ms"), step.bActive ? (end - step.Started) * 1000.0 : 0.0);
+    ret->SetNumberField(T("frame"), GFrameCounter);
+    if (world != nullptr)
+        ret->SetNumberField(T("world_time"), world->GetTimeSeconds());
+    return ret;
+}
+
+// Conditions understood by IsSettled, in the order they are reported.
+static const TCHAR* QUIESCE_CONDITIONS[] = {
+    T("loading"), T("registry"), T("shaders"), T("textures"), T("gc"),
+};
+
+/*
+ *  True once the given part of the engine has nothing left to do:
+ *
+ *      loading     No async package loading, including our own loads.
+ *      registry    The asset registry has finished discovering assets.
+ *      shaders     The shader compile queue is empty.
+ *      textures    Texture streaming wants no more mips.
+ *      gc          No garbage collection is pending or being purged.
+ *
+ *  Returns false for unknown conditions.
+ */
+bool
+URCHTTP::IsSettled(const FString& condition) const
+{
+    if (condition == T("loading"))
+        return !IsAsyncLoading() && InFlightLoads.Num() == 0;
+    if (condition == T("registry"))
+        return !FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get().IsLoadingAssets();
+    if (condition == T("shaders"))
+        return !IsCompilingShaders();
+    if (condition == T("textures"))
+        return IStreamingManager::Get().GetNumWantingResources() == 0;
+    if (condition == T("gc"))
+        return !gc_pending && !gc_progress.bPurging;
+    return false;
+}
+
+/*
+ *  Respond to `conn` once every one of `conditions` has held for `frames`
+ *  consecutive frames (at least one), or with `202` after `timeoutS`.  The
+ *  response reports the state of each condition.
+ */
+void
+URCHTTP::DeferQuiesceReply(struct mg_connection* conn, const TArray<FString>& conditions,
+                           int32 frames, double timeoutS)
+{
+    double started = FPlatformTime::Seconds();
+    int32  settled = 0;
+
+    DeferReply(conn, timeoutS, [this, conditions, frames, started, settled]
+               (bool bTimedOut, int& status, FString& json) mutable -> bool
+    {
+        TSharedRef<FJsonObject> state = MakeShareable(new FJsonObject);
+        bool all = true;
+
+        for (auto& condition : conditions)
+        {
+            bool ok = IsSettled(condition);
+            state->SetBoolField(condition, ok);
+            all = all && ok;
+        }
+
+        settled = all ? settled + 1 : 0;
+        bool done = settled >= FMath::Max(frames, 1);
+        if (!done && !bTimedOut)
+            return false;
+
+        TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+        ret->SetBoolField(T("settled"), done);
+        ret->SetNumberField(T("settled_frames"), settled);
+        ret->SetNumberField(T("elapsed_ms"), (FPlatformTime::Seconds() - started) * 1000.0);
+        ret->SetObjectField(T("conditions"), state);
+
+        status = done ? 200 : 202;
+        json   = json_to_string(ret);
+        return true;
+    });
+}
+
+/*
+ *  Collect the streamed textures used by `targets`, each of which is either
+ *  a package path (all textures in packages under it) or the name or label
+ *  of an actor in the stepped world (the textures its primitives render
+ *  with).  Targets that match nothing are counted in `unknown`.
+ */
+TArray<TWeakObjectPtr<UTexture2D>>
+URCHTTP::FindTextures(const TArray<FString>& targets, int32& unknown) const
+{
+    TSet<UTexture2D*> found;
+    UWorld* world = step_world();
+
+    unknown = 0;
+    for (auto& target : targets)
+    {
+        int32 before = found.Num();
+        bool  matched = false;
+
+        if (target.StartsWith(T("/")))
+        {
+            for (TObjectIterator<UTexture2D> it; it; ++it)
+            {
+                if (it->GetOutermost()->GetName().StartsWith(target))
+                    found.Add(*it);
+            }
+            matched = found.Num() > before;
+        }
+        else if (world != nullptr)
+        {
+            for (TActorIterator<AActor> it(world); it; ++it)
+            {
+#if WITH_EDITOR
+                if (it->GetName() != target && it->GetActorLabel() != target)
+                    continue;
+#else
+                if (it->GetName() != target)
+                    continue;
+#endif
+                matched = true;
+
+                TArray<UPrimitiveComponent*> primitives;
+                it->GetComponents(primitives);
+                for (auto primitive : primitives)
+                {
+                    TArray<UTexture*> textures;
+                    primitive->GetUsedTextures(textures, EMaterialQualityLevel::Num);
+                    for (auto texture : textures)
+                    {
+                        if (UTexture2D* texture2d = Cast<UTexture2D>(texture))
+                            found.Add(texture2d);
+                    }
+                }
+            }
+        }
+
+        if (!matched)
+        {
+            LOG("No textures found for %s", *target);
+            unknown++;
+        }
+    }
+
+    TArray<TWeakObjectPtr<UTexture2D>> ret;
+    for (auto texture : found)
+        ret.Add(texture);
+    return ret;
+}
+
+/*
+ *  Describe texture streaming, and how many of `textures` have all of their
+ *  mips resident.
+ */
+TSharedRef<FJsonObject>
+URCHTTP::GetTextureStreamingStatus(const TArray<TWeakObjectPtr<UTexture2D>>& textures) const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    int32 resident = 0, pending = 0;
+
+    for (auto& texture : textures)
+    {
+        if (!texture.IsValid())
+            continue;
+        if (texture->IsFullyStreamedIn())
+            resident++;
+        else
+            pending++;
+    }
+
+    ret->SetNumberField(T("wanting_resources"), IStreamingManager::Get().GetNumWantingResources());
+    ret->SetNumberField(T("textures"), resident + pending);
+    ret->SetNumberField(T("resident"), resident);
+    ret->SetNumberField(T("pending"), pending);
+    return ret;
+}
+
+/*
+ *  Respond once every one of `textures` is fully streamed in and texture
+ *  streaming has settled, or with `202` after `timeoutS`.
+ */
+void
+URCHTTP::DeferTextureReply(struct mg_connection* conn,
+                           const TArray<TWeakObjectPtr<UTexture2D>>& textures, double timeoutS)
+{
+    DeferReply(conn, timeoutS, [this, textures](bool bTimedOut, int& status, FString& json) -> bool
+    {
+        TSharedRef<FJsonObject> ret = GetTextureStreamingStatus(textures);
+        bool done = ret->GetIntegerField(T("pending")) == 0 &&
+                    ret->GetIntegerField(T("wanting_resources")) == 0;
+        if (!done && !bTimedOut)
+            return false;
+
+        status = done ? 200 : 202;
+        json   = json_to_string(ret);
+        return true;
+    });
+}
+
+/*
+ *  Stop rendering so that all of the game thread's frame goes to loading
+ *  and importing: level viewports stop redrawing every frame and game
+ *  rendering is disabled.  Disabling restores exactly what was changed.
+ */
+void
+URCHTTP::SetThroughputMode(bool bEnable)
+{
+#if WITH_EDITOR
+    if (bEnable == throughput.bActive)
+        return;
+
+    if (bEnable)
+    {
+        throughput.Realtime.Reset();
+        for (auto client : GEditor->LevelViewportClients)
+        {
+            throughput.Realtime.Add(client, client->IsRealtime());
+            client->SetRealtime(false);
+        }
+
+        throughput.bPrevGameRendering = FViewport::IsGameRenderingEnabled();
+        FViewport::SetGameRenderingEnabled(false);
+        LOG("Throughput mode on, %d viewports no longer realtime", throughput.Realtime.Num());
+    }
+    else
+    {
+        // Viewports may have been closed in the meantime
+        for (auto client : GEditor->LevelViewportClients)
+        {
+            if (bool* realtime = throughput.Realtime.Find(client))
+            {
+                client->SetRealtime(*realtime);
+                client->Invalidate();
+            }
+        }
+
+        FViewport::SetGameRenderingEnabled(throughput.bPrevGameRendering);
+        throughput.Realtime.Reset();
+        LOG("Throughput mode off", NULL);
+    }
+
+    throughput.bActive = bEnable;
+#endif
+}
+
+TSharedRef<FJsonObject>
+URCHTTP::GetThroughputMode() const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    ret->SetBoolField(T("active"), throughput.bActive);
+    ret->SetNumberField(T("viewports"), throughput.Realtime.Num());
+    ret->SetBoolField(T("game_rendering"), FViewport::IsGameRenderingEnabled());
+    return ret;
+}
+
+// A client without an open connection counts as connected for this long
+// after its last request.
+static const double ORCHESTRATED_IDLE_S = 30.0;
+
+/*
+ *  While orchestrated the editor never throttles itself for being in the
+ *  background, since the server is only polled as often as the editor
+ *  ticks.  The previous settings are restored afterwards.
+ */
+void
+URCHTTP::SetOrchestrated(bool bEnable)
+{
+    if (bEnable == orchestrated)
+        return;
+
+    IConsoleVariable* idle = IConsoleManager::Get().FindConsoleVariable(T("t.IdleWhenNotForeground"));
+
+#if WITH_EDITOR
+    UEditorPerformanceSettings* settings = GetMutableDefault<UEditorPerformanceSettings>();
+#endif
+
+    if (bEnable)
+    {
+#if WITH_EDITOR
+        prev_throttle_cpu = settings->bThrottleCPUWhenNotForeground;
+        settings->bThrottleCPUWhenNotForeground = false;
+#endif
+        if (idle != nullptr)
+        {
+            prev_idle_when_not_foreground = idle->GetInt();
+            idle->Set(0);
+        }
+    }
+    else
+    {
+#if WITH_EDITOR
+        settings->bThrottleCPUWhenNotForeground = prev_throttle_cpu;
+#endif
+        if (idle != nullptr)
+            idle->Set(prev_idle_when_not_foreground);
+    }
+
+    orchestrated = bEnable;
+    LOG("Orchestrated mode %s", bEnable ? T("on") : T("off"));
+}
+
+/*
+ *  Track the tick rate and enter or leave orchestrated mode as clients come
+ *  and go.
+ */
+void
+URCHTTP::TickOrchestrated()
+{
+    double now = FPlatformTime::Seconds();
+
+    if (last_tick_time > 0.0)
+    {
+        double ms = (now - last_tick_time) * 1000.0;
+        tick_ms_avg = tick_ms_avg > 0.0 ? tick_ms_avg * 0.9 + ms * 0.1 : ms;
+        tick_ms_max = FMath::Max(tick_ms_max * 0.999, ms);
+    }
+    last_tick_time = now;
+
+    // A client that keeps its connection open stays connected while idle
+    client_connections = 0;
+    for (struct mg_connection* c = mg_next(&mgr, nullptr); c != nullptr; c = mg_next(&mgr, c))
+    {
+        if (!(c->flags & MG_F_LISTENING))
+            client_connections++;
+    }
+
+    bool connected = client_connections > 0 ||
+        (last_request_time > 0.0 && now - last_request_time < ORCHESTRATED_IDLE_S);
+    if (orchestrated_mode == T("on"))
+        SetOrchestrated(true);
+    else if (orchestrated_mode == T("off"))
+        SetOrchestrated(false);
+    else
+        SetOrchestrated(connected);
+}
+
+bool
+URCHTTP::SetOrchestratedMode(const FString& mode)
+{
+    if (mode != T("auto") && mode != T("on") && mode != T("off"))
+        return false;
+    orchestrated_mode = mode;
+    return true;
+}
+
+TSharedRef<FJsonObject>
+URCHTTP::GetMetrics() const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    double now = FPlatformTime::Seconds();
+
+    ret->SetStringField(T("orchestrated_mode"), orchestrated_mode);
+    ret->SetBoolField(T("orchestrated"), orchestrated);
+    ret->SetNumberField(T("tick_ms"), tick_ms_avg);
+    ret->SetNumberField(T("tick_ms_max"), tick_ms_max);
+    ret->SetNumberField(T("tick_rate_hz"), tick_ms_avg > 0.0 ? 1000.0 / tick_ms_avg : 0.0);
+    ret->SetNumberField(T("frame"), GFrameCounter);
+    ret->SetNumberField(T("requests"), requests_total);
+    ret->SetNumberField(T("connections"), client_connections);
+    ret->SetNumberField(T("seconds_since_request"), last_request_time > 0.0 ? now - last_request_time : -1.0);
+    ret->SetNumberField(T("deferred_replies"), DeferredReplies.Num());
+    ret->SetNumberField(T("jobs"), Jobs.Num());
+    return ret;
+}
+
+/*
+ *  Capture the state read-only queries are answered from.  Called at the
+ *  end of every tick.
+ */
+void
+URCHTTP::PublishSnapshot()
+{
+    FEngineState state;
+
+    state.Frame              = GFrameCounter;
+    state.Published          = FPlatformTime::Seconds();
+    state.TickMs             = tick_ms_avg;
+    state.bAsyncLoading      = !IsSettled(T("loading"));
+    state.bRegistryLoading   = !IsSettled(T("registry"));
+#if WITH_EDITOR
+    state.bPlayInEditor      = GEditor != nullptr && GEditor->PlayWorld != nullptr;
+#else
+    state.bPlayInEditor      = false;
+#endif
+    state.bCompilingShaders  = IsCompilingShaders();
+    state.bGarbageCollecting = !IsSettled(T("gc"));
+    state.bOrchestrated      = orchestrated;
+    state.ShaderJobs         = GShaderCompilingManager ? GShaderCompilingManager->GetNumRemainingJobs() : 0;
+    state.InFlightLoads      = InFlightLoads.Num();
+    state.MountedPaks        = MountedPaks.Num();
+    state.Uploads            = Uploads.Num();
+    state.Jobs               = Jobs.Num();
+    state.DeferredReplies    = DeferredReplies.Num();
+    state.UsedPhysical       = used_physical();
+
+    Snapshot->Publish(state);
+}
+
+TSharedRef<FJsonObject>
+URCHTTP::GetStatus() const
+{
+    FEngineState state;
+    uint64 version = Snapshot->Read(state);
+    return state.ToJson(version);
+}
+
+void
+URCHTTP::GameRenderSync()
+{
+    static FFrameEndSync FrameEndSync;
+    /* Do a full sync without allowing a frame of lag */
+    FrameEndSync.Sync(false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// HTTP responses.
+const mg_str_t STATUS_OK              = mg_mk_str("OK\r\n");
+const mg_str_t STATUS_ERROR           = mg_mk_str("ERROR\r\n");
+const mg_str_t STATUS_TRY_AGAIN       = mg_mk_str("TRY AGAIN\r\n");
+const mg_str_t STATUS_NOT_SUPPORTED   = mg_mk_str("NOT SUPPORTED\r\n");
+const mg_str_t STATUS_NOT_IMPLEMENTED = mg_mk_str("NOT IMPLEMENTED\r\n");
+const mg_str_t STATUS_BAD_ACTION      = mg_mk_str("BAD ACTION\r\n");
+const mg_str_t STATUS_BAD_ENTITY      = mg_mk_str("BAD ENTITY\r\n");
+
+// HTTP query responses.
+const mg_str_t STATUS_TRUE            = mg_mk_str("TRUE\r\n");
+const mg_str_t STATUS_FALSE           = mg_mk_str("FALSE\r\n");
+
+// Helper to match a list of URIs.
+template<typename... Strings> bool
+matches_any(mg_str_t* s, Strings... args)
+{
+    std::vector<std::string> items = {args...};
+    for (int i = 0; i < items.size(); i++)
+        if (mg_vcmp(s, items[i].c_str()) == 0)
+            return true;
+    return false;
+}
+
+// Fetch a variable from the query string, empty if it is not present.
+static FString
+query_var(http_message_t* msg, const char* name)
+{
+    char buf[1024];
+    int  len = mg_get_http_var(&msg->query_string, name, buf, sizeof(buf));
+    if (len <= 0)
+        return FString();
+    return FString(UTF8_TO_TCHAR(buf));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  Called for each part of a POST /uploadpak body as it arrives.  The data
+ *  is appended to a temporary file and dropped from the connection's
+ *  receive buffer so that only one socket read is ever held in memory.
+ */
+void
+URCHTTP::ReceivePakUpload(struct mg_connection* conn, http_message_t* msg)
+{
+    TSharedPtr<FPakUpload>* found = Uploads.Find(conn);
+    TSharedPtr<FPakUpload>  upload;
+
+    if (found == nullptr)
+    {
+        FString name = FPaths::GetCleanFilename(query_var(msg, "name"));
+        FString sha1 = query_var(msg, "sha1");
+
+        upload = MakeShareable(new FPakUpload);
+        upload->PakPath = FPaths::ProjectSavedDir() / T("Paks") / name;
+        upload->Bytes   = 0;
+
+        // A second upload of the same pak would write into the same file
+        bool duplicate = false;
+        for (auto& it : Uploads)
+            duplicate = duplicate || it.Value->PakPath == upload->PakPath;
+
+        if (duplicate)
+        {
+            LOG("%s is already being uploaded", *name);
+        }
+        else if (sha1.Len() == 0)
+        {
+            // Refused before any of the body is written
+            LOG("Upload of %s has no sha1; pass sha1=skip to not verify it", *name);
+        }
+        else if (name.EndsWith(T(".pak")))
+        {
+            IPlatformFile& platform = IPlatformFile::GetPlatformPhysical();
+            FString        tempPath = upload->PakPath + T(".part");
+
+            platform.CreateDirectoryTree(*FPaths::GetPath(upload->PakPath));
+            upload->File.Reset(platform.OpenWrite(*tempPath));
+
+            // Only an upload that owns its temporary file may delete it
+            if (upload->File.IsValid())
+                upload->TempPath = tempPath;
+        }
+
+        if (upload->File.IsValid())
+            LOG("Receiving pak upload into %s", *upload->TempPath);
+        else
+            LOG("Unable to receive pak upload '%s'", *name);
+
+        Uploads.Add(conn, upload);
+    }
+    else
+    {
+        upload = *found;
+    }
+
+    if (upload->File.IsValid() && msg->body.len > 0)
+    {
+        const uint8* data = (const uint8*)msg->body.p;
+        if (upload->File->Write(data, msg->body.len))
+        {
+            upload->Hash.Update(data, msg->body.len);
+            upload->Bytes += msg->body.len;
+        }
+        else
+        {
+            LOG("Write to %s failed after %lld bytes", *upload->TempPath, upload->Bytes);
+            upload->File.Reset();
+        }
+    }
+
+    conn->flags |= MG_F_DELETE_CHUNK;
+}
+
+/*
+ *  Called once the whole body has been received.  Returns the upload with
+ *  its file closed, or nullptr if it could not be written.
+ */
+TSharedPtr<FPakUpload>
+URCHTTP::FinishPakUpload(struct mg_connection* conn)
+{
+    TSharedPtr<FPakUpload> upload;
+
+    if (!Uploads.RemoveAndCopyValue(conn, upload))
+        return nullptr;
+
+    if (!upload->File.IsValid())
+    {
+        if (upload->TempPath.Len() > 0)
+            IPlatformFile::GetPlatformPhysical().DeleteFile(*upload->TempPath);
+        return nullptr;
+    }
+
+    upload->File.Reset();
+    upload->Hash.Final();
+    return upload;
+}
+
+void
+URCHTTP::AbortPakUpload(struct mg_connection* conn)
+{
+    TSharedPtr<FPakUpload> upload;
+
+    if (Uploads.RemoveAndCopyValue(conn, upload))
+    {
+        LOG("Pak upload into %s aborted after %lld bytes", *upload->PakPath, upload->Bytes);
+        upload->File.Reset();
+        if (upload->TempPath.Len() > 0)
+            IPlatformFile::GetPlatformPhysical().DeleteFile(*upload->TempPath);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// How long finished jobs can still be queried.
+static const double JOB_RETENTION_S = 600.0;
+
+// Send a JSON response, possibly from outside of the event handler.
+static void
+send_json(struct mg_connection* conn, int status, const FString& json)
+{
+    FTCHARToUTF8 utf8(*json);
+    mg_send_head(conn, status, utf8.Length(), "Content-Type: application/json");
+    mg_send(conn, utf8.Get(), utf8.Length());
+}
+
+static bool
+update_job(FOrcJob& job)
+{
+    if (job.State != T("running"))
+        return true;
+    if (!job.Update(job))
+        return false;
+
+    if (job.State == T("running"))
+        job.State = T("done");
+    job.Finished = FPlatformTime::Seconds();
+    job.Update   = nullptr;
+    LOG("Job %d (%s) %s after %.1fms", job.Id, *job.Kind, *job.State,
+        (job.Finished - job.Started) * 1000.0);
+    return true;
+}
+
+/*
+ *  Start a job.  It is updated once straight away, so work that needs no
+ *  waiting completes before this returns.
+ */
+int32
+URCHTTP::StartJob(const FString& kind, TFunction<bool(FOrcJob&)> update)
+{
+    TSharedPtr<FOrcJob> job = MakeShareable(new FOrcJob);
+    job->Id       = ++next_job_id;
+    job->Kind     = kind;
+    job->State    = T("running");
+    job->Started  = FPlatformTime::Seconds();
+    job->Finished = 0.0;
+    job->Update   = MoveTemp(update);
+
+    Jobs.Add(job->Id, job);
+    update_job(*job);
+    return job->Id;
+}
+
+TSharedPtr<FOrcJob>
+URCHTTP::FindJob(int32 id) const
+{
+    const TSharedPtr<FOrcJob>* job = Jobs.Find(id);
+    return job ? *job : nullptr;
+}
+
+void
+URCHTTP::TickJobs()
+{
+    double now = FPlatformTime::Seconds();
+
+    for (auto it = Jobs.CreateIterator(); it; ++it)
+    {
+        FOrcJob& job = *it.Value();
+        if (update_job(job) && now - job.Finished > JOB_RETENTION_S)
+            it.RemoveCurrent();
+    }
+}
+
+TSharedRef<FJsonObject>
+URCHTTP::GetJobStatus(const FOrcJob& job) const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    double end = job.State == T("running") ? FPlatformTime::Seconds() : job.Finished;
+
+    ret->SetNumberField(T("job"), job.Id);
+    ret->SetStringField(T("kind"), job.Kind);
+    ret->SetStringField(T("state"), job.State);
+    ret->SetNumberField(T("elapsed_ms"), (end - job.Started) * 1000.0);
+    if (job.Result.IsValid())
+        ret->SetObjectField(T("result"), job.Result);
+    return ret;
+}
+
+TSharedRef<FJsonObject>
+URCHTTP::GetJobs() const
+{
+    TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+    TArray<TSharedPtr<FJsonValue>> jobs;
+
+    for (auto& it : Jobs)
+    {
+        TSharedRef<FJsonObject> job = GetJobStatus(*it.Value);
+        job->RemoveField(T("result"));
+        jobs.Add(MakeShareable(new FJsonValueObject(job)));
+    }
+    ret->SetArrayField(T("jobs"), jobs);
+    return ret;
+}
+
+/*
+ *  Respond to `conn` from a later tick, once `poll` says so or at most
+ *  `timeoutS` seconds from now.  Replies that are ready straight away are
+ *  sent immediately.
+ */
+void
+URCHTTP::DeferReply(struct mg_connection* conn, double timeoutS,
+                    TFunction<bool(bool bTimedOut, int& Status, FString& Json)> poll)
+{
+    FDeferredReply reply;
+    reply.Conn     = conn;
+    reply.Deadline = FPlatformTime::Seconds() + FMath::Max(timeoutS, 0.0);
+    reply.Poll     = MoveTemp(poll);
+
+    int     status = 200;
+    FString json;
+    if (reply.Poll(timeoutS <= 0.0, status, json))
+        send_json(conn, status, json);
+    else
+        DeferredReplies.Add(MoveTemp(reply));
+}
+
+/*
+ *  Respond with the job's status once it finishes, or with `202` and its
+ *  current status if it is still running after `timeoutS` seconds.
+ */
+void
+URCHTTP::DeferJobReply(struct mg_connection* conn, int32 jobId, double timeoutS)
+{
+    DeferReply(conn, timeoutS, [this, jobId](bool bTimedOut, int& status, FString& json) -> bool
+    {
+        TSharedPtr<FOrcJob> job = FindJob(jobId);
+        if (!job.IsValid())
+        {
+            status = 404;
+            json   = T("{}");
+            return true;
+        }
+
+        if (job->State == T("running") && !bTimedOut)
+            return false;
+
+        status = job->State == T("running") ? 202 : 200;
+        json   = json_to_string(GetJobStatus(*job));
+        return true;
+    });
+}
+
+void
+URCHTTP::TickDeferredReplies()
+{
+    double now = FPlatformTime::Seconds();
+
+    for (int32 i = 0; i < DeferredReplies.Num(); )
+    {
+        int     status = 200;
+        FString json;
+        if (DeferredReplies[i].Poll(now >= DeferredReplies[i].Deadline, status, json))
+        {
+            send_json(DeferredReplies[i].Conn, status, json);
+            DeferredReplies.RemoveAt(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void
+URCHTTP::DropDeferredReplies(struct mg_connection* conn)
+{
+    DeferredReplies.RemoveAll([conn](const FDeferredReply& reply) {
+        return reply.Conn == conn;
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void
+ev_handler(struct mg_connection* conn, int ev, void *ev_data)
+{
+    /*
+     *  Pak uploads are streamed to disk as their body arrives instead of
+     *  being buffered in full.
+     */
+    if (ev == MG_EV_HTTP_CHUNK)
+    {
+        http_message_t* msg = (http_message_t *)ev_data;
+        if (matches_any(&msg->uri, "/uploadpak", "/ue4/uploadpak"))
+            URCHTTP::Get()->ReceivePakUpload(conn, msg);
+        return;
+    }
+    else if (ev == MG_EV_CLOSE)
+    {
+        URCHTTP::Get()->AbortPakUpload(conn);
+        URCHTTP::Get()->DropDeferredReplies(conn);
+        return;
+    }
+
+    if (ev != MG_EV_HTTP_REQUEST)
+        return;
+
+    URCHTTP::Get()->NoteRequest();
+
+    http_message_t* msg       = (http_message_t *)ev_data;
+    mg_str_t        rspMsg    = STATUS_ERROR;
+    FString         rspJson;
+    int             rspStatus = 404;
+    URCHTTP*        server    = URCHTTP::Get();
+
+#if WITH_EDITOR
+    auto ar = "AssetRegistry";
+    FAssetRegistryModule& AssetRegistry =
+        FModuleManager::LoadModuleChecked<FAssetRegistryModule>(ar);
+
+    /*
+     *  HTTP GET commands
+     */
+    if (mg_vcmp(&msg->method, "GET") == 0)
+    {
+        /*
+         *  HTTP GET /
+         *
+         *  Return "OK"
+         */
+        if (matches_any(&msg->uri, "/"))
+        {
+            goto OK;
+        }
+
+        /*
+         *  HTTP GET /play
+         *
+         *  Trigger a play in the current level.
+         */
+        else if (matches_any(&msg->uri, "/play", "/ue4/play"))
+        {
+            GEditor->PlayMap(NULL, NULL, -1, -1, false);
+            goto OK;
+        }
+
+        /*
+         *  HTTP GET /play
+         *
+         *  Trigger a play in the current level.
+         */
+        else if (matches_any(&msg->uri, "/stop", "/ue4/stop"))
+        {
+            FLvlEditor &Editor =
+                FManager::LoadModuleChecked<FLvlEditor>("LevelEditor");
+
+            if (!Editor.GetFirstActiveViewport().IsValid())
+            {
+                LOG("%s", "ERROR no valid viewport");
+                goto ERROR;
+            }
+
+            if (Editor.GetFirstActiveViewport()->HasPlayInEditorViewport())
+            {
+                FString cmd = "Exit";
+                auto ew = GEditor->GetEditorWorldContext().World();
+                GEditor->Exec(ew, *cmd, *GLog);
+            }
+            goto OK;
+        }
+
+        /*
+         *  HTTP GET /shutdown-now
+         *
+         *  Trigger an editor immediate (possibly unclean) shutdown.
+         */
+        else if (matches_any(&msg->uri, "/shutdown-now", "/ue4/shutdown-now"))
+        {
+            FGenericPlatformMisc::RequestExit(true);
+            goto OK;
+        }
+
+        /*
+         *  HTTP GET /shutdown
+         *
+         *  Trigger an editor shutdown.
+         */
+        else if (matches_any(&msg->uri, "/shutdown", "/ue4/shutdown"))
+        {
+            FGenericPlatformMisc::RequestExit(false);
+            goto OK;
+        }
+
+        /*
+         *  HTTP GET /build
+         *
+         *  Trigger a build all for the current level.
+         */
+        else if (matches_any(&msg->uri, "/build", "/ue4/build"))
+        {
+            FLevelEditorActionCallbacks::Build_Execute();
+            goto OK;
+        }
+
+        /*
+         *  HTTP GET /is_building
+         *
+         *  Returns TRUE if the editor is currently building, FALSE otherwise.
+         */
+        else if (matches_any(&msg->uri, "/is_building", "/ue4/is_building"))
+        {
+            bool ok = FLevelEditorActionCallbacks::Build_CanExecute();
+            goto NOT_IMPLEMENTED;
+        }
+
+        /*
+         *  HTTP GET /list_assets
+         *
+         *  Logs all the assets that are registered with the asset manager.
+         */
+        else if (matches_any(&msg->uri, "/list_assets", "/ue4/list_assets"))
+        {
+            TArray<FAssetData> AssetData;
+            AssetRegistry.Get().GetAllAssets(AssetData);
+            for (auto data : AssetData)
+            {
+                FString path = *(data.PackageName.ToString());
+                FPaths::MakePlatformFilename(path);
+                LOG("%s %s", *(data.PackageName.ToString()), *path);
+            }
+            goto OK;
+        }
+
+        /*
+         *  HTTP GET /assets_idle
+         *
+         *  Returns OK if the importer is idle.  Returns a status code to try
+         *  again otherwise.
+         */
+        else if (matches_any(&msg->uri, "/assets_idle", "/ue4/assets_idle"))
+        {
+            if (AssetRegistry.Get().IsLoadingAssets())
+                goto ONE_MO_TIME;
+            goto OK;
+        }
+
+        /*
+         *  HTTP GET /debug
+         *
+         *  Catch-all debug endpoint.
+         */
+        else if (matches_any(&msg->uri, "/debug", "/ue4/debug"))
+        {
+            debugFn("");
+            goto OK;
+        }
+
+        /*
+         *  HTTP GET /gc[?mode=incremental[&budget_ms=<ms>]]
+         *
+         *  Collect garbage.  By default this is a full collection and purge
+         *  before responding.  In incremental mode only the mark phase runs
+         *  before responding, and unreachable objects are purged over the
+         *  following ticks within `budget_ms` (default 2ms) per tick.
+         */
+        else if (matches_any(&msg->uri, "/gc"))
+        {
+            if (query_var(msg, "mode") == T("incremental"))
+            {
+                FString budget = query_var(msg, "budget_ms");
+                server->StartIncrementalGarbageCollect(budget.Len() ? FCString::Atof(*budget) : 2.0f);
+                goto OK;
+            }
+            URCHTTP::Get()->GarbageCollect();
+            goto OK;
+        }
+
+        /*
+         *  HTTP GET /prefetch
+         *
+         *  Returns JSON describing the objects held by POST /prefetch.
+         */
+        else if (matches_any(&msg->uri, "/prefetch", "/ue4/prefetch"))
+        {
+            rspJson = json_to_string(server->GetObjectPrefetchStatus());
+            goto JSON;
+        }
+
+        /*
+         *  HTTP GET /shaders
+         *
+         *  Returns JSON describing outstanding shader compilation.
+         */
+        else if (matches_any(&msg->uri, "/shaders", "/ue4/shaders"))
+        {
+            rspJson = json_to_string(server->GetShaderCompileStatus());
+            goto JSON;
+        }
+
+        /*
+         *  HTTP GET /shaders/workers
+         *
+         *  Returns JSON describing the shader compile workers, their CPU
+         *  usage and the limits they run under.
+         */
+        else if (matches_any(&msg->uri, "/shaders/workers", "/ue4/shaders/workers"))
+        {
+            rspJson = json_to_string(server->GetShaderWorkers()->GetStatus());
+            goto JSON;
+        }
+
+        /*
+         *  HTTP GET /shaders/wait[?timeout_ms=<ms>]
+         *
+         *  Respond once no shaders are being compiled, or with `202` after
+         *  `timeout_ms` (default 60000).  The editor keeps ticking, and
+         *  serving other requests, in the meantime.
+         */
+        else if (matches_any(&msg->uri, "/shaders/wait", "/ue4/shaders/wait"))
+        {
+            FString timeout = query_var(msg, "timeout_ms");
+            double  timeout_s = timeout.Len() ? FCString::Atod(*timeout) / 1000.0 : 60.0;
+
+            server->DeferReply(conn, timeout_s, [server](bool bTimedOut, int& status, FString& json) -> bool
+            {
+                bool compiling = server->IsCompilingShaders();
+                if (compiling && !bTimedOut)
+                    return false;
+
+                status = compiling ? 202 : 200;
+                json   = json_to_string(server->GetShaderCompileStatus());
+                return true;
+            });
+            return;
+        }
+
+        /*
+         *  HTTP GET /fence
+         *
+         *  Begin a render fence in the current frame and return JSON with
+         *  the frame's `id`, to be waited on with /fence/wait.
+         */
+        else if (matches_any(&msg->uri, "/fence", "/ue4/fence"))
+        {
+            TSharedRef<FJsonObject> json = MakeShareable(new FJsonObject);
+            json->SetNumberField(T("id"), server->BeginFrameFence());
+            rspJson = json_to_string(json);
+            goto JSON;
+        }
+
+        /*
+         *  HTTP GET /fence/wait?id=<id>[&timeout_ms=<ms>]
+         *
+         *  Respond once the render thread has passed frame `id`, or with
+         *  `202` after `timeout_ms` (default 10000).  Neither the game nor
+         *  the render thread is stalled in the meantime.
+         */
+        else if (matches_any(&msg->uri, "/fence/wait", "/ue4/fence/wait"))
+        {
+            FString id      = query_var(msg, "id");
+            FString timeout = query_var(msg, "timeout_ms");
+            if (id.Len() == 0)
+                goto BAD_ENTITY;
+
+            uint64 frame     = FCString::Strtoui64(*id, nullptr, 10);
+            double timeout_s = timeout.Len() ? FCString::Atod(*timeout) / 1000.0 : 10.0;
+
+            server->DeferReply(conn, timeout_s, [server, frame](bool bTimedOut, int& status, FString& json) -> bool
+            {
+                bool rendered = server->IsFrameRendered(frame);
+                if (!rendered)
+                {
+                    // Fenced from the first frame after it, once that comes around
+                    if (GFrameCounter > frame)
+                        server->BeginFrameFence();
+                    if (!bTimedOut)
+                        return false;
+                }
+
+                TSharedRef<FJsonObject> ret = MakeShareable(new FJsonObject);
+                ret->SetNumberField(T("id"), frame);
+                ret->SetNumberField(T("frame"), GFrameCounter);
+                ret->SetBoolField(T("rendered"), rendered);
+
+                status = rendered ? 200 : 202;
+                json   = json_to_string(ret);
+                return true;
+            });
+            return;
+        }
+
+        /*
+         *  HTTP GET /step
+         *
+         *  Returns JSON describing step mode and the last step.
+         */
+        else if (matches_any(&msg->uri, "/step", "/ue4/step"))
+        {
+            rspJson = json_to_string(server->GetStepStatus());
+            goto JSON;
         }
 
         /*
-         *  HTTP GET /play
+         *  HTTP GET /quiesce[?conditions=<a,b,...>][&frames=<n>][&timeout_ms=<ms>]
          *
-         *  Trigger a play in the current level.
+         *  Respond once the engine has settled: every condition (by default
+         *  all of them, see URCHTTP::IsSettled) has held for `frames`
+         *  consecutive frames, or with `202` after `timeout_ms` (default
+         *  60000).
          */
-        else if (matches_any(&msg->uri, "/stop", "/ue4/stop"))
+        else if (matches_any(&msg->uri, "/quiesce", "/ue4/quiesce"))
         {
-            FLvlEditor &Editor =
-                FManager::LoadModuleChecked<FLvlEditor>("LevelEditor");
-
-            if (!Editor.GetFirstActiveViewport().IsValid())
+            TArray<FString> conditions;
+            query_var(msg, "conditions").ParseIntoArray(conditions, T(","), true);
+            if (conditions.Num() == 0)
             {
-                LOG("%s", "ERROR no valid viewport");
-                goto ERROR;
+                for (auto condition : QUIESCE_CONDITIONS)
+                    conditions.Add(condition);
             }
 
-            if (Editor.GetFirstActiveViewport()->HasPlayInEditorViewport())
+            for (auto& condition : conditions)
             {
-                FString cmd = "Exit";
-                auto ew = GEditor->GetEditorWorldContext().World();
-                GEditor->Exec(ew, *cmd, *GLog);
+                bool known = false;
+                for (auto name : QUIESCE_CONDITIONS)
+                    known = known || condition == name;
+                if (!known)
+                    goto BAD_ENTITY;
             }
-            goto OK;
+
+            FString timeout = query_var(msg, "timeout_ms");
+            int32   frames  = FCString::Atoi(*query_var(msg, "frames"));
+            server->DeferQuiesceReply(conn, conditions, frames,
+                                      timeout.Len() ? FCString::Atod(*timeout) / 1000.0 : 60.0);
+            return;
         }
 
         /*
-         *  HTTP GET /shutdown-now
+         *  HTTP GET /textures
          *
-         *  Trigger an editor immediate (possibly unclean) shutdown.
+         *  Returns JSON describing pending texture streaming work across
+         *  all loaded textures.
          */
-        else if (matches_any(&msg->uri, "/shutdown-now", "/ue4/shutdown-now"))
+        else if (matches_any(&msg->uri, "/textures", "/ue4/textures"))
         {
-            FGenericPlatformMisc::RequestExit(true);
-            goto OK;
+            TArray<TWeakObjectPtr<UTexture2D>> textures;
+            for (TObjectIterator<UTexture2D> it; it; ++it)
+                textures.Add(*it);
+            rspJson = json_to_string(server->GetTextureStreamingStatus(textures));
+            goto JSON;
         }
 
         /*
-         *  HTTP GET /shutdown
+         *  HTTP GET /throughput
          *
-         *  Trigger an editor shutdown.
+         *  Returns JSON describing whether throughput mode is on.
          */
-        else if (matches_any(&msg->uri, "/shutdown", "/ue4/shutdown"))
+        else if (matches_any(&msg->uri, "/throughput", "/ue4/throughput"))
         {
-            FGenericPlatformMisc::RequestExit(false);
-            goto OK;
+            rspJson = json_to_string(server->GetThroughputMode());
+            goto JSON;
         }
 
         /*
-         *  HTTP GET /build
+         *  HTTP GET /metrics
          *
-         *  Trigger a build all for the current level.
+         *  Returns JSON with the effective tick rate, orchestrated mode and
+         *  request counters.
          */
-        else if (matches_any(&msg->uri, "/build", "/ue4/build"))
+        else if (matches_any(&msg->uri, "/metrics", "/ue4/metrics"))
         {
-            FLevelEditorActionCallbacks::Build_Execute();
-            goto OK;
+            rspJson = json_to_string(server->GetMetrics());
+            goto JSON;
         }
 
         /*
-         *  HTTP GET /is_building
+         *  HTTP GET /status
          *
-         *  Returns TRUE if the editor is currently building, FALSE otherwise.
+         *  Returns JSON describing the engine state as of the end of the
+         *  last tick.  The same is served from the status port without
+         *  waiting for a tick.
          */
-        else if (matches_any(&msg->uri, "/is_building", "/ue4/is_building"))
+        else if (matches_any(&msg->uri, "/status", "/ue4/status"))
         {
-            bool ok = FLevelEditorActionCallbacks::Build_CanExecute();
-            goto NOT_IMPLEMENTED;
+            rspJson = json_to_string(server->GetStatus());
+            goto JSON;
         }
 
         /*
-         *  HTTP GET /list_assets
+         *  HTTP GET /job?id=<id>
          *
-         *  Logs all the assets that are registered with the asset manager.
+         *  Return JSON describing a job started by an earlier request.
          */
-        else if (matches_any(&msg->uri, "/list_assets", "/ue4/list_assets"))
+        else if (matches_any(&msg->uri, "/job", "/ue4/job"))
         {
-            TArray<FAssetData> AssetData;
-            AssetRegistry.Get().GetAllAssets(AssetData);
-            for (auto data : AssetData)
-            {
-                FString path = *(data.PackageName.ToString());
-                FPaths::MakePlatformFilename(path);
-                LOG("%s %s", *(data.PackageName.ToString()), *path);
-            }
-            goto OK;
+            TSharedPtr<FOrcJob> job = server->FindJob(FCString::Atoi(*query_var(msg, "id")));
+            if (!job.IsValid())
+                goto BAD_ENTITY;
+            rspJson = json_to_string(server->GetJobStatus(*job));
+            goto JSON;
         }
 
         /*
-         *  HTTP GET /assets_idle
+         *  HTTP GET /jobs
          *
-         *  Returns OK if the importer is idle.  Returns a status code to try
-         *  again otherwise.
+         *  Return JSON listing running and recently finished jobs.
          */
-        else if (matches_any(&msg->uri, "/assets_idle", "/ue4/assets_idle"))
+        else if (matches_any(&msg->uri, "/jobs", "/ue4/jobs"))
         {
-            if (AssetRegistry.Get().IsLoadingAssets())
-                goto ONE_MO_TIME;
-            goto OK;
+            rspJson = json_to_string(server->GetJobs());
+            goto JSON;
         }
 
         /*
-         *  HTTP GET /debug
+         *  HTTP GET /gc/status
          *
-         *  Catch-all debug endpoint.
+         *  Returns JSON describing the progress of the last incremental
+         *  garbage collection.
          */
-        else if (matches_any(&msg->uri, "/debug", "/ue4/debug"))
+        else if (matches_any(&msg->uri, "/gc/status"))
         {
-            debugFn("");
-            goto OK;
+            rspJson = json_to_string(server->GetGarbageCollectStatus());
+            goto JSON;
         }
 
-        else if (matches_any(&msg->uri, "/gc"))
+        /*
+         *  HTTP GET /prefetchpak
+         *
+         *  Returns a JSON description of the paks queued for, or warmed by,
+         *  the background prefetcher and the number of bytes read so far.
+         */
+        else if (matches_any(&msg->uri, "/prefetchpak", "/ue4/prefetchpak"))
         {
-            URCHTTP::Get()->GarbageCollect();
-            goto OK;
+            rspJson = json_to_string(server->GetPrefetcher()->GetStatus());
+            goto JSON;
+        }
+
+        /*
+         *  HTTP GET /paks
+         *
+         *  Returns a JSON description of the mounted pak files and the
+         *  resident memory budget they are kept under.
+         */
+        else if (matches_any(&msg->uri, "/paks", "/ue4/paks"))
+        {
+            rspJson = json_to_string(server->GetMountedPaks());
+            goto JSON;
         }
 
         goto BAD_ACTION;
@@ -415,9 +3175,16 @@ ev_handler(struct mg_connection* conn, int ev, void *ev_data)
          *
          *  POST body should contain a comma separated list of the following two
          *  arguments:
-         *  1. Local .pak file path to mount into the engine.
-         *  2. "all" or "none" to indicate if the pak's content should be loaded
+         *  1. Local .pak file path, or http:// URL, to mount into the engine.
+         *  2. "all" or "none" to indicate if the pak's content should be loaded,
+         *     or a ';' separated content filter (see FPakContentFilter::Parse).
          *
+         *  Alternatively the body can be a JSON object with a `pak_path` and
+         *  optional `load`, `include`, `exclude` and `classes` fields.
+         *
+         *  With `?shaders=1` (or `shaders: true` in the JSON) the pak's
+         *  materials are loaded in the background and their shaders compiled;
+         *  the response is then the status of the job that tracks that.
          */
         else if (matches_any(&msg->uri, "/loadpak", "/ue4/loadpak"))
         {
@@ -425,64 +3192,478 @@ ev_handler(struct mg_connection* conn, int ev, void *ev_data)
             {
                 int32 num_params;
                 TArray<FString> pak_options;
+                TSharedPtr<FJsonObject> json;
 
                 FString pakPath;
+                FPakContentFilter filter;
 
                 body.TrimEndInline();
 
-                num_params = body.ParseIntoArray(pak_options, T(","), true);
-                pakPath = pak_options[0];
+                auto reader = TJsonReaderFactory<>::Create(body);
+                if (FJsonSerializer::Deserialize(reader, json) && json.IsValid())
+                {
+                    json->TryGetStringField(T("pak_path"), pakPath);
+                    filter = FPakContentFilter::FromJson(json);
+                }
+                else
+                {
+                    num_params = body.ParseIntoArray(pak_options, T(","), true);
+                    if (num_params != 2)
+                        goto ERROR;
+
+                    pakPath = pak_options[0];
+                    filter  = FPakContentFilter::Parse(pak_options[1]);
+                }
 
                 if (pakPath.Len() == 0)
                     goto ERROR;
 
-                if (num_params != 2)
+                LOG("Mounting pak file: %s", *pakPath);
+
+                if (URCHTTP::Get()->MountPakFile(pakPath, filter) < 0)
                     goto ERROR;
 
-                LOG("Mounting pak file: %s", *pakPath);
+                bool shaders = query_var(msg, "shaders") == T("1");
+                if (json.IsValid())
+                    json->TryGetBoolField(T("shaders"), shaders);
+
+                if (shaders)
+                {
+                    int32 job = server->WarmPakShaders(pakPath);
+                    if (job < 0)
+                        goto ERROR;
+                    rspJson = json_to_string(server->GetJobStatus(*server->FindJob(job)));
+                    goto JSON;
+                }
+                goto OK;
+            }
+            goto BAD_ENTITY;
+        }
+
+        /*
+         *  HTTP POST /ue4/uploadpak?name=<file>.pak&sha1=<hex>|skip[&load=<filter>]
+         *
+         *  POST body is the raw contents of a .pak file, of any size.  It is
+         *  streamed into the project's Saved/Paks directory, verified against
+         *  the SHA-1, unless that is "skip", and then mounted.  `load` selects the content
+         *  to load exactly like the second argument of /loadpak, and defaults
+         *  to "none".  `shaders=1` warms the pak's shaders as for /loadpak.
+         */
+        else if (matches_any(&msg->uri, "/uploadpak", "/ue4/uploadpak"))
+        {
+            TSharedPtr<FPakUpload> upload = server->FinishPakUpload(conn);
+            if (!upload.IsValid())
+                goto BAD_ENTITY;
+
+            FString sha1     = BytesToHex(upload->Hash.m_Digest, sizeof(upload->Hash.m_Digest));
+            FString expected = query_var(msg, "sha1");
+            FString load     = query_var(msg, "load");
 
-                if (URCHTTP::Get()->MountPakFile(pakPath, pak_options[1] == T("all")) < 0)
+            IPlatformFile& platform = IPlatformFile::GetPlatformPhysical();
+            if (expected != T("skip") && expected != sha1)   // FString compares case-insensitively
+            {
+                LOG("Pak upload %s has SHA-1 %s, expected %s", *upload->PakPath, *sha1, *expected);
+                platform.DeleteFile(*upload->TempPath);
+                goto BAD_ENTITY;
+            }
+
+            if (server->IsPakMounted(upload->PakPath))
+            {
+                LOG("Pak %s is mounted, unload it before uploading it again", *upload->PakPath);
+                platform.DeleteFile(*upload->TempPath);
+                goto ERROR;
+            }
+
+            platform.DeleteFile(*upload->PakPath);
+            if (!platform.MoveFile(*upload->PakPath, *upload->TempPath))
+                goto ERROR;
+
+            LOG("Mounting uploaded pak file: %s (%lld bytes)", *upload->PakPath, upload->Bytes);
+            if (server->MountPakFile(upload->PakPath, FPakContentFilter::Parse(load.Len() ? load : T("none"))) < 0)
+                goto ERROR;
+
+            TSharedRef<FJsonObject> json = MakeShareable(new FJsonObject);
+            json->SetStringField(T("pak_path"), FPaths::ConvertRelativePathToFull(upload->PakPath));
+            json->SetNumberField(T("bytes"), upload->Bytes);
+            json->SetStringField(T("sha1"), sha1);
+            if (query_var(msg, "shaders") == T("1"))
+            {
+                int32 job = server->WarmPakShaders(upload->PakPath);
+                if (job < 0)
                     goto ERROR;
+                json->SetNumberField(T("shaders_job"), job);
+            }
+            rspJson = json_to_string(json);
+            goto JSON;
+        }
+
+        /*
+         *  HTTP POST /ue4/unloadpak
+         *
+         *  POST body should contain a comma separated list of previously
+         *  mounted .pak files.  Content loaded from each pak is released, and
+         *  the pak, its mount point and its registry entries are removed.
+         */
+        else if (matches_any(&msg->uri, "/unloadpak", "/ue4/unloadpak"))
+        {
+            if (body.Len() > 0)
+            {
+                TArray<FString> paks;
+
+                body.TrimEndInline();
+                body.ParseIntoArray(paks, T(","), true);
+
+                int failed = 0;
+                for (auto& pak : paks)
+                {
+                    LOG("Unmounting pak file: %s", *pak);
+                    if (server->UnmountPakFile(pak) < 0)
+                        failed++;
+                }
 
+                if (failed > 0)
+                    goto ERROR;
+                server->GarbageCollect();
                 goto OK;
             }
             goto BAD_ENTITY;
         }
 
-        else if (matches_any(&msg->uri, "/loadobj", "/ue4/loadobj"))
+        /*
+         *  HTTP POST /ue4/prefetchpak
+         *
+         *  POST body should contain a comma separated list of local .pak
+         *  files whose contents should be read into the OS page cache in the
+         *  background ahead of a `/loadpak`.
+         */
+        else if (matches_any(&msg->uri, "/prefetchpak", "/ue4/prefetchpak"))
         {
             if (body.Len() > 0)
             {
+                TArray<FString> paks;
+
                 body.TrimEndInline();
+                body.ParseIntoArray(paks, T(","), true);
 
+                for (auto& pak : paks)
+                    server->GetPrefetcher()->Enqueue(pak);
+                goto OK;
+            }
+            goto BAD_ENTITY;
+        }
+
+        /*
+         *  HTTP POST /ue4/upcoming_paks
+         *
+         *  POST body should contain the comma separated list of .pak files
+         *  that are expected to be mounted next, in order.  This replaces
+         *  any previously declared list; each pak is warmed in the
+         *  background and dropped from the list once it is mounted.  An
+         *  empty body clears the list.
+         */
+        else if (matches_any(&msg->uri, "/upcoming_paks", "/ue4/upcoming_paks"))
+        {
+            TArray<FString> paks;
+
+            body.TrimEndInline();
+            body.ParseIntoArray(paks, T(","), true);
+
+            server->GetPrefetcher()->SetUpcoming(paks);
+            goto OK;
+        }
+
+        /*
+         *  HTTP POST /gc/scheduler
+         *
+         *  POST body should contain a JSON object configuring automatic
+         *  garbage collection (see the README for the fields).  Fields that
+         *  are left out keep their current value.
+         */
+        else if (matches_any(&msg->uri, "/gc/scheduler"))
+        {
+            TSharedPtr<FJsonObject> json;
+            auto reader = TJsonReaderFactory<>::Create(body);
+            if (!FJsonSerializer::Deserialize(reader, json) || !json.IsValid())
+                goto BAD_ENTITY;
+
+            server->ConfigureGarbageCollectScheduler(json);
+            rspJson = json_to_string(server->GetGarbageCollectStatus());
+            goto JSON;
+        }
+
+        /*
+         *  HTTP POST /shaders/workers
+         *
+         *  POST body should contain a JSON object with the number of `cores`
+         *  shader compile workers may use (0 for all) and their `nice` value.
+         */
+        else if (matches_any(&msg->uri, "/shaders/workers", "/ue4/shaders/workers"))
+        {
+            TSharedPtr<FJsonObject> json;
+            auto reader = TJsonReaderFactory<>::Create(body);
+            if (!FJsonSerializer::Deserialize(reader, json) || !json.IsValid())
+                goto BAD_ENTITY;
+
+            TSharedRef<FJsonObject> status = server->GetShaderWorkers()->GetStatus();
+            int32 cores = status->GetIntegerField(T("cores"));
+            int32 nice  = status->GetIntegerField(T("nice"));
+            json->TryGetNumberField(T("cores"), cores);
+            json->TryGetNumberField(T("nice"), nice);
+
+            server->GetShaderWorkers()->Configure(cores, nice);
+            rspJson = json_to_string(server->GetShaderWorkers()->GetStatus());
+            goto JSON;
+        }
+
+        /*
+         *  HTTP POST /step?n=<frames>[&dt=<seconds>][&render=1][&timeout_ms=<ms>]
+         *
+         *  Advance the world by `n` ticks of exactly `dt` (default 1/30)
+         *  seconds and respond once they have completed, or with `202` after
+         *  `timeout_ms` (default 60000).  See URCHTTP::StartStep.
+         */
+        else if (matches_any(&msg->uri, "/step", "/ue4/step"))
+        {
+            FString dt      = query_var(msg, "dt");
+            FString timeout = query_var(msg, "timeout_ms");
+            int32   frames  = FCString::Atoi(*query_var(msg, "n"));
+            bool    render  = query_var(msg, "render") == T("1");
+
+            if (server->IsStepping())
+                goto ONE_MO_TIME;
+            if (server->StartStep(frames, dt.Len() ? FCString::Atof(*dt) : 1.0f / 30.0f, render) < 0)
+                goto BAD_ENTITY;
+
+            double timeout_s = timeout.Len() ? FCString::Atod(*timeout) / 1000.0 : 60.0;
+            server->DeferReply(conn, timeout_s, [server](bool bTimedOut, int& status, FString& json) -> bool
+            {
+                if (server->IsStepping() && !bTimedOut)
+                    return false;
+
+                status = server->IsStepping() ? 202 : 200;
+                json   = json_to_string(server->GetStepStatus());
+                return true;
+            });
+            return;
+        }
+
+        /*
+         *  HTTP POST /step/release
+         *
+         *  Leave step mode, restoring real-time ticking.
+         */
+        else if (matches_any(&msg->uri, "/step/release", "/ue4/step/release"))
+        {
+            if (server->IsStepping())
+                goto ONE_MO_TIME;
+            server->ReleaseStepMode();
+            goto OK;
+        }
+
+        /*
+         *  HTTP POST /textures[?seconds=<s>][&timeout_ms=<ms>]
+         *
+         *  POST body should contain a comma or newline separated list of
+         *  package paths and actor names whose textures are forced fully
+         *  resident for `seconds` (default 30).  The response is sent once
+         *  those textures are streamed in and streaming has settled, or with
+         *  `202` after `timeout_ms` (default 30000).  An empty body only
+         *  waits for streaming to settle.
+         */
+        else if (matches_any(&msg->uri, "/textures", "/ue4/textures"))
+        {
+            const TCHAR* delims[] = { T(","), T("\n"), T("\r") };
+            TArray<FString> targets;
+            body.ParseIntoArray(targets, delims, 3, true);
+            for (auto& target : targets)
+                target.TrimStartAndEndInline();
+            targets.RemoveAll([](const FString& target) { return target.Len() == 0; });
+
+            FString seconds = query_var(msg, "seconds");
+            FString timeout = query_var(msg, "timeout_ms");
+            int32   unknown = 0;
+
+            TArray<TWeakObjectPtr<UTexture2D>> textures = server->FindTextures(targets, unknown);
+            if (unknown > 0)
+                goto BAD_ENTITY;
+
+            float force_s = seconds.Len() ? FCString::Atof(*seconds) : 30.0f;
+            for (auto& texture : textures)
+                texture->SetForceMipLevelsToBeResident(force_s);
+
+            server->DeferTextureReply(conn, textures, timeout.Len() ? FCString::Atod(*timeout) / 1000.0 : 30.0);
+            return;
+        }
+
+        /*
+         *  HTTP POST /throughput
+         *
+         *  POST body should contain 1 to stop rendering level viewports and
+         *  the game while bulk loading or importing, or 0 to restore them.
+         */
+        else if (matches_any(&msg->uri, "/throughput", "/ue4/throughput"))
+        {
+            body.TrimStartAndEndInline();
+            if (body != T("0") && body != T("1"))
+                goto BAD_ENTITY;
+
+            server->SetThroughputMode(body == T("1"));
+            rspJson = json_to_string(server->GetThroughputMode());
+            goto JSON;
+        }
+
+        /*
+         *  HTTP POST /orchestrated
+         *
+         *  POST body should contain "auto" (the default), "on" or "off".  In
+         *  orchestrated mode the editor does not throttle itself when it is
+         *  in the background; "auto" turns it on while clients are making
+         *  requests.
+         */
+        else if (matches_any(&msg->uri, "/orchestrated", "/ue4/orchestrated"))
+        {
+            body.TrimStartAndEndInline();
+            if (!server->SetOrchestratedMode(body))
+                goto BAD_ENTITY;
+            goto OK;
+        }
+
+        /*
+         *  HTTP POST /pak_cache
+         *
+         *  POST body should contain the number of megabytes that the on-disk
+         *  block cache for paks mounted from http:// URLs may occupy.  The
+         *  cache is shared by all editors on the host.
+         */
+        else if (matches_any(&msg->uri, "/pak_cache", "/ue4/pak_cache"))
+        {
+            int64 mb = FCString::Atoi64(*body);
+            if (mb <= 0)
+                goto BAD_ENTITY;
+            server->SetPakCacheLimit(mb * 1024 * 1024);
+            goto OK;
+        }
+
+        /*
+         *  HTTP POST /pak_budget
+         *
+         *  POST body should contain the number of megabytes that content
+         *  loaded from mounted paks may occupy.  Least recently used paks are
+         *  evicted once this is exceeded.  0 disables the budget.
+         */
+        else if (matches_any(&msg->uri, "/pak_budget", "/ue4/pak_budget"))
+        {
+            int64 mb = FCString::Atoi64(*body);
+            server->SetPakBudget(mb * 1024 * 1024);
+            goto OK;
+        }
+
+        /*
+         *  HTTP POST /ue4/prefetch[?ttl_s=<seconds>]
+         *
+         *  POST body should contain a comma or newline separated list of
+         *  objects that will be loaded soon.  They are loaded in the
+         *  background behind any other load and held for `ttl_s` (default
+         *  60) seconds, unless /loadobj claims them before then.
+         */
+        else if (matches_any(&msg->uri, "/prefetch", "/ue4/prefetch"))
+        {
+            const TCHAR* delims[] = { T(","), T("\n"), T("\r") };
+            TArray<FString> objects;
+            body.ParseIntoArray(objects, delims, 3, true);
+            for (auto& obj : objects)
+                obj.TrimStartAndEndInline();
+            objects.RemoveAll([](const FString& obj) { return obj.Len() == 0; });
+
+            if (objects.Num() == 0)
+                goto BAD_ENTITY;
+
+            FString ttl = query_var(msg, "ttl_s");
+            rspJson = json_to_string(server->PrefetchObjects(objects, ttl.Len() ? FCString::Atod(*ttl) : 60.0));
+            goto JSON;
+        }
+
+        /*
+         *  HTTP POST /ue4/loadobj[?class=<Class>][&timeout_ms=<ms>]
+         *
+         *  POST body should contain the path of the object to load, or a
+         *  comma or newline separated list of them.  Each object must be of
+         *  the given class, which is either named by the `class` query
+         *  parameter or by writing the path as `Class'/Path/To/Package.Object'`.
+         *
+         *  A single path without `timeout_ms` is loaded synchronously.
+         *  Anything else is loaded by one async request whose job status is
+         *  returned once it completes, or after `timeout_ms` with `202`.
+         */
+        else if (matches_any(&msg->uri, "/loadobj", "/ue4/loadobj"))
+        {
+            if (body.Len() > 0)
+            {
+                const TCHAR* delims[] = { T(","), T("\n"), T("\r") };
                 TArray<FString> objects;
-                int32 num_params = body.ParseIntoArray(objects, T(","), true);
+                body.ParseIntoArray(objects, delims, 3, true);
+                for (auto& obj : objects)
+                    obj.TrimStartAndEndInline();
+                objects.RemoveAll([](const FString& obj) { return obj.Len() == 0; });
 
-                if (num_params==1)
+                FString timeout = query_var(msg, "timeout_ms");
+                if (objects.Num() == 1 && timeout.Len() == 0)
                 {
-                    if (URCHTTP::Get()->LoadObject(objects[0]) != nullptr)
-                        goto OK;
-                    goto ERROR;
+                    UObject* obj = server->LoadObject(objects[0], query_var(msg, "class"));
+                    if (obj == nullptr)
+                        goto ERROR;
+                    rspJson = json_to_string(server->DescribeObject(obj));
+                    goto JSON;
+                }
+                else if (objects.Num() > 0)
+                {
+                    double timeout_s = timeout.Len() ? FCString::Atod(*timeout) / 1000.0 : 30.0;
+                    int32  job       = server->LoadObjects(objects, query_var(msg, "class"));
+                    server->DeferJobReply(conn, job, timeout_s);
+                    return;
                 }
             }
             goto BAD_ENTITY;
         }
 
+        /*
+         *  HTTP POST /ue4/unloadobj[?reset_loaders=1][&gc=deferred|now|none]
+         *
+         *  POST body should contain a comma or newline separated list of
+         *  objects to unload.  The plugin's handles on them are released
+         *  and a single garbage collection reclaims them; by default it is
+         *  deferred to the end of the tick so that it is shared by every
+         *  unload received in the meantime.
+         */
         else if (matches_any(&msg->uri, "/unloadobj", "/ue4/unloadobj"))
         {
             if (body.Len() > 0)
             {
-                body.TrimEndInline();
-
+                const TCHAR* delims[] = { T(","), T("\n"), T("\r") };
                 TArray<FString> objects;
-                int32 num_params = body.ParseIntoArray(objects, T(","), true);
+                body.ParseIntoArray(objects, delims, 3, true);
+                for (auto& obj : objects)
+                    obj.TrimStartAndEndInline();
+                objects.RemoveAll([](const FString& obj) { return obj.Len() == 0; });
+
+                bool    reset = query_var(msg, "reset_loaders") == T("1");
+                FString gc    = query_var(msg, "gc");
 
-                if (num_params == 1)
+                int failed = 0;
+                for (auto& obj : objects)
                 {
-                    if (URCHTTP::Get()->UnloadObject(objects[0]) < 0)
-                        goto ERROR;
-                    goto OK;
+                    if (server->UnloadObject(obj, reset) < 0)
+                        failed++;
                 }
+
+                if (gc == T("now"))
+                    server->GarbageCollect();
+                else if (gc != T("none"))
+                    server->RequestGarbageCollect();
+
+                if (failed > 0)
+                    goto ERROR;
+                goto OK;
             }
             goto BAD_ENTITY;
         }
@@ -531,11 +3712,15 @@ ev_handler(struct mg_connection* conn, int ev, void *ev_data)
   OK:
     rspMsg    = STATUS_OK;
     rspStatus = 200;
-#pragma GCC diagnostic pop
 
   done:
     mg_send_head(conn, rspStatus, rspMsg.len, "Content-Type: text/plain");
     mg_printf(conn, "%s", rspMsg.p);
+    return;
+
+  JSON:
+    send_json(conn, 200, rspJson);
+#pragma GCC diagnostic pop
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -551,20 +3736,35 @@ URCHTTP::Get()
 ////////////////////////////////////////////////////////////////////////////////
 
 URCHTTP::URCHTTP(const FObjectInitializer& oi)
-    : Super(oi), poll_interval(0), poll_ms(1)
+    : Super(oi), poll_interval(0), poll_ms(1), gc_pending(false), gc_scheduler_checked(0),
+      requests_this_tick(0), next_job_id(0), prefetch_hits(0), prefetch_expired(0),
+      fence_rendered_frame(0), orchestrated_mode(T("auto")), orchestrated(false),
+      prev_throttle_cpu(true), prev_idle_when_not_foreground(1), last_request_time(0),
+      client_connections(0), requests_total(0), last_tick_time(0), tick_ms_avg(0), tick_ms_max(0),
+      Snapshot(nullptr), StatusServer(nullptr), pak_budget(0), Prefetcher(nullptr),
+      ShaderWorkers(nullptr), upload_poll_ms(8)
 {
-    // Initialize .pak file reader
+    // Initialize .pak file reader, on top of the HTTP pak reader
     if (PakFileMgr == nullptr)
     {
+        HttpPakFile = new FHttpPakPlatformFile;
+        HttpPakFile->Initialize(&FPlatformFileManager::Get().GetPlatformFile(), T(""));
+
         PakFileMgr = new FPakPlatformFile;
-        PakFileMgr->Initialize(&FPlatformFileManager::Get().GetPlatformFile(), T(""));
+        PakFileMgr->Initialize(HttpPakFile, T(""));
         PakFileMgr->InitializeNewAsyncIO();
     }
 }
 
 URCHTTP::~URCHTTP()
 {
+    FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
+    FCoreDelegates::OnEndFrame.RemoveAll(this);
     mg_mgr_free(&mgr);
+    delete StatusServer;
+    delete Snapshot;
+    delete Prefetcher;
+    delete ShaderWorkers;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -572,6 +3772,30 @@ URCHTTP::~URCHTTP()
 void
 URCHTTP::Init()
 {
+    // Start the background pak reader
+    Prefetcher = new FPakPrefetcher;
+    ShaderWorkers = new FShaderWorkerControl;
+
+    /*
+     *  Put the pak reader on top of the platform file chain for good, so
+     *  that loads issued in one tick can still read mounted paks in later
+     *  ones.  Files that are not in a mounted pak fall through to the
+     *  platform file that was current until now.
+     */
+    HttpPakFile->SetLowerLevel(&FPlatformFileManager::Get().GetPlatformFile());
+    FPlatformFileManager::Get().SetPlatformFile(*PakFileMgr);
+
+    // Keep the object cache free of collected objects
+    FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &URCHTTP::OnPostGarbageCollect);
+
+    // Unrendered steps run outside of any world's tick
+    FCoreDelegates::OnEndFrame.AddUObject(this, &URCHTTP::OnEndFrame);
+
+    // Probes are answered from the snapshot on a port and thread of their own
+    Snapshot = new FStateSnapshot;
+    PublishSnapshot();
+    StatusServer = new FStatusServer(*Snapshot, "18821");
+
     // Initialize HTTPD server
     mg_mgr_init(&mgr, NULL);
     conn = mg_bind(&mgr, "18820", ev_handler);
@@ -591,9 +3815,37 @@ URCHTTP::Tick(float dt)
     if (tick_counter == 0)
         Init();
 
+    requests_this_tick = 0;
     if (poll_interval == 0 || (tick_counter++ % poll_interval) == 0)
         mg_mgr_poll(&mgr, poll_ms);
 
+    TickJobs();
+    TickDeferredReplies();
+    TickObjectPrefetches();
+    TickFences();
+    TickStepMode();
+    TickOrchestrated();
+    ShaderWorkers->Tick();
+
+    if (gc_pending)
+    {
+        gc_pending = false;
+        GarbageCollect();
+    }
+
+    TickIncrementalGarbageCollect();
+
+    // Only collect on our own initiative when nobody is waiting on us
+    if (requests_this_tick == 0 && Uploads.Num() == 0)
+        TickGarbageCollectScheduler();
+
+    // Keep draining pak uploads for a bounded slice of the frame
+    double until = FPlatformTime::Seconds() + upload_poll_ms / 1000.0;
+    while (Uploads.Num() > 0 && FPlatformTime::Seconds() < until)
+        mg_mgr_poll(&mgr, 0);
+
+    PublishSnapshot();
+
     if (tick_counter == 0)
         tick_counter++;
 }
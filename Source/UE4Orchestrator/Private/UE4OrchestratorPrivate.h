@@ -7,6 +7,210 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+class FPakPrefetcher;
+class FHttpPakPlatformFile;
+class FShaderWorkerControl;
+class FStateSnapshot;
+class FStatusServer;
+class FRenderCommandFence;
+class UTexture2D;
+class FLevelEditorViewportClient;
+
+/*
+ *  Selects which of a pak's files get loaded once it is mounted.  A file is
+ *  loaded if it matches any `Include` wildcard (or there are none), matches
+ *  no `Exclude` wildcard, and its asset class is one of `Classes` (or there
+ *  are none).  Wildcards are matched against the file's path in the pak.
+ */
+struct FPakContentFilter
+{
+    bool            bLoad;
+    TArray<FString> Include;
+    TArray<FString> Exclude;
+    TArray<FName>   Classes;
+
+    FPakContentFilter(bool bInLoad = false) : bLoad(bInLoad) {}
+
+    /*
+     *  Parses "all", "none" or a list of ';' separated terms where
+     *  `class=<Name>` selects an asset class, `!<wildcard>` excludes files
+     *  and any other term is an include wildcard.
+     */
+    static FPakContentFilter Parse(const FString& Spec);
+    static FPakContentFilter FromJson(const TSharedPtr<FJsonObject>& Json);
+
+    bool MatchesPath(const FString& File) const;
+    bool MatchesClass(const FAssetData& Asset) const;
+};
+
+/*
+ *  Book-keeping for a pak file mounted through URCHTTP::MountPakFile.
+ */
+struct FMountedPak
+{
+    FString         PakPath;
+    FString         MountPoint;
+    FString         PathOnDisk;
+    FString         PackageRoot;        // Long package path of MountPoint, e.g. /Game/Props/
+    TArray<FString> Objects;            // Object paths loaded from the pak
+    int64           ResidentBytes;      // Approximate memory held by Objects
+    double          LastUse;            // FPlatformTime::Seconds() of last use
+};
+
+/*
+ *  A pak file whose body is being streamed to disk by POST /uploadpak.
+ */
+struct FPakUpload
+{
+    FString                 PakPath;        // Final location of the pak
+    FString                 TempPath;       // Where the body is written to, empty if not opened
+    TUniquePtr<IFileHandle> File;
+    FSHA1                   Hash;
+    int64                   Bytes;
+};
+
+/*
+ *  Progress of an incremental garbage collection started by the plugin.
+ */
+struct FGCProgress
+{
+    bool   bPurging      = false;
+    float  BudgetMs      = 0.0f;    // Time spent purging per tick
+    double Started       = 0.0;
+    int32  Frames        = 0;       // Ticks spent purging so far
+    double BusyMs        = 0.0;     // Time spent marking and purging so far
+    int32  ObjectsBefore = 0;
+    uint64 RssBefore     = 0;
+};
+
+/*
+ *  Long running work started by a request.  `Update` is called every tick
+ *  until it returns true, by which time it has set `State` and `Result`.
+ *  Jobs can be queried by id with GET /job until a while after they
+ *  finish.
+ */
+struct FOrcJob
+{
+    int32                     Id;
+    FString                   Kind;         // Endpoint that started the job
+    FString                   State;        // "running", "done" or "failed"
+    double                    Started;
+    double                    Finished;
+    TSharedPtr<FJsonObject>   Result;
+    TFunction<bool(FOrcJob&)> Update;
+};
+
+/*
+ *  A response that is sent from a later tick.  `Poll` is called every tick
+ *  until it returns true after filling in the response; `bTimedOut` is set
+ *  once `Deadline` has passed, and `Poll` must then respond.
+ */
+struct FDeferredReply
+{
+    struct mg_connection* Conn;
+    double                Deadline;
+    TFunction<bool(bool bTimedOut, int& Status, FString& Json)> Poll;
+};
+
+/*
+ *  One of the objects of a POST /loadobj batch.
+ */
+struct FLoadItem
+{
+    FString Path;                   // As requested
+    FString ObjectPath;             // Normalized
+    UClass* Class;
+    FString Status;                 // "pending", "resident", "loaded" or "failed"
+    double  LoadMs;
+    bool    bCoalesced;             // Joined a load that was already in flight
+};
+
+/*
+ *  Objects loaded ahead of time by one POST /prefetch.  They are held by
+ *  `Handle` until /loadobj claims them or `Expires` passes.
+ */
+struct FObjectPrefetch
+{
+    TSharedPtr<FStreamableHandle> Handle;
+    TSet<FString>                 Unclaimed;    // Normalized object paths
+    double                        Expires  = 0.0;
+    bool                          bLoading = false;
+};
+
+/*
+ *  JSON returned by /loadobj for an object, computed on first use.
+ */
+struct FObjectDescriptor
+{
+    TWeakObjectPtr<UObject> Object;
+    TSharedPtr<FJsonObject> Json;
+};
+
+/*
+ *  State of the fixed step frame advance driven by POST /step.  The
+ *  `Prev` fields are restored when step mode is released.
+ */
+struct FStepMode
+{
+    bool                   bActive      = false;
+    bool                   bRender      = false;
+    TWeakObjectPtr<UWorld> World;
+    float                  DeltaSeconds = 0.0f;
+    int32                  Frames       = 0;    // Ticks requested by the last step
+    int32                  Pending      = 0;    // Ticks of it still to run
+    uint64                 StartFrame   = 0;    // GFrameCounter when it was started
+    double                 Started      = 0.0;
+    double                 Finished     = 0.0;
+
+    bool                   bPrevFixedTimeStep   = false;
+    double                 PrevFixedDeltaTime   = 0.0;
+    bool                   bPrevSmoothFrameRate = false;
+    bool                   bPrevPaused          = false;
+};
+
+/*
+ *  What POST /throughput changed, to be restored when it is turned off.
+ */
+struct FThroughputMode
+{
+    bool                                    bActive            = false;
+    TMap<FLevelEditorViewportClient*, bool> Realtime;       // Previous realtime settings
+    bool                                    bPrevGameRendering = true;
+};
+
+/*
+ *  Telemetry for the garbage collections run by the plugin.
+ */
+struct FGCStats
+{
+    int32   Count            = 0;
+    double  LastTime         = 0.0;
+    FString LastReason       = TEXT("request");
+    double  LastDurationMs   = 0.0;
+    double  TotalDurationMs  = 0.0;
+    int32   LastObjectsFreed = 0;
+    int64   LastBytesFreed   = 0;
+    int32   LoadsSinceLast   = 0;   // Objects loaded since the last collection
+};
+
+/*
+ *  Thresholds that trigger automatic garbage collection.  A value of 0
+ *  disables the corresponding trigger.
+ */
+struct FGCScheduler
+{
+    bool   bEnabled     = false;
+    bool   bIncremental = true;
+    double BudgetMs     = 2.0;
+    int64  RssBytes     = 0;
+    int32  UObjects     = 0;
+    int32  Loads        = 0;
+    double MinIntervalS = 10.0;     // Never collect more often than this
+    double MaxIntervalS = 0.0;      // Collect after loads once this has passed
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 UCLASS()
 class UE4ORCHESTRATOR_API URCHTTP : public UObject, public FTickableGameObject
 {
@@ -58,6 +262,162 @@ class UE4ORCHESTRATOR_API URCHTTP : public UObject, public FTickableGameObject
      */
     FPakPlatformFile *PakFileMgr;
 
+    /*
+     *  Lower level of `PakFileMgr` that serves paks mounted from http://
+     *  URLs out of a shared on-disk block cache.
+     */
+    FHttpPakPlatformFile *HttpPakFile;
+
+    FString ResolvePakPath(const FString& PakPath) const;
+
+    /*
+     *  Objects resolved by LoadObject keyed by their normalized path, so
+     *  repeated references to the same asset skip the object hash lookup.
+     *  Stale entries are dropped after every garbage collection.
+     */
+    TMap<FString, TWeakObjectPtr<UObject>> ObjectCache;
+    TMap<FString, TWeakObjectPtr<UClass>>  ClassCache;
+
+    // Keyed by the object's path name, and pruned like ObjectCache
+    TMap<FString, FObjectDescriptor>       Descriptors;
+
+    /*
+     *  Streamable handles created by LoadObject, keyed by normalized path.
+     *  They keep their objects loaded until UnloadObject releases them.
+     */
+    TMap<FString, TSharedPtr<FStreamableHandle>> Handles;
+
+    bool         gc_pending;
+    FGCProgress  gc_progress;
+    FGCStats     gc_stats;
+    FGCScheduler gc_scheduler;
+    double       gc_scheduler_checked;
+
+    void TickIncrementalGarbageCollect();
+    void TickGarbageCollectScheduler();
+    void RecordGarbageCollect();
+
+    // Number of HTTP requests handled during the current tick
+    int requests_this_tick;
+
+    void OnPostGarbageCollect();
+
+    /*
+     *  Jobs keyed by their id, and responses waiting on them (or on
+     *  anything else that completes over several ticks).
+     */
+    TMap<int32, TSharedPtr<FOrcJob>> Jobs;
+    int32                            next_job_id;
+    TArray<FDeferredReply>           DeferredReplies;
+
+    void TickJobs();
+    void TickDeferredReplies();
+
+    // Hold an object with a streamable handle of its own, as LoadObject does
+    void ClaimObject(const FString& ObjectPath, UObject* Obj);
+
+    /*
+     *  Async loads in flight, keyed by the normalized path of each object
+     *  they load.  Every load of an object joins the one in flight.
+     */
+    TMap<FString, TSharedPtr<FStreamableHandle>> InFlightLoads;
+
+    TSharedPtr<FStreamableHandle> FindInFlightLoad(const FString& ObjectPath) const;
+    void AddInFlightLoads(const TArray<FSoftObjectPath>& ObjectPaths,
+                          const TSharedPtr<FStreamableHandle>& Handle);
+    void RemoveInFlightLoads(const TSharedPtr<FStreamableHandle>& Handle);
+
+    /*
+     *  Prefetched objects that have not been claimed yet, keyed by their
+     *  normalized path.
+     */
+    TArray<TSharedPtr<FObjectPrefetch>>         ObjectPrefetches;
+    TMap<FString, TSharedPtr<FObjectPrefetch>> PrefetchedObjects;
+    int32                                       prefetch_hits;
+    int32                                       prefetch_expired;
+
+    bool ClaimPrefetched(const FString& ObjectPath);
+    void TickObjectPrefetches();
+
+    /*
+     *  Render fences begun by GET /fence, keyed by frame.  Completed ones
+     *  are dropped each tick, remembering the latest frame one was begun
+     *  in; every frame before that one has been rendered.
+     */
+    TMap<uint64, TSharedPtr<FRenderCommandFence>> Fences;
+    uint64                                        fence_rendered_frame;
+
+    void TickFences();
+
+    FStepMode       step;
+    FThroughputMode throughput;
+
+    void TickStepMode();
+    void OnEndFrame();
+
+    /*
+     *  Orchestrated mode: background throttling is disabled so requests
+     *  are not held up by a slow tick.  `orchestrated_mode` is "auto", in
+     *  which case it is on while a client is connected or requests keep
+     *  coming in, "on" or "off".
+     */
+    FString orchestrated_mode;
+    bool    orchestrated;
+    bool    prev_throttle_cpu;
+    int32   prev_idle_when_not_foreground;
+    double  last_request_time;
+    int32   client_connections;     // Open on the main port, as of the last tick
+    int64   requests_total;
+
+    // Tick interval, smoothed and decaying maximum
+    double  last_tick_time;
+    double  tick_ms_avg;
+    double  tick_ms_max;
+
+    void SetOrchestrated(bool bEnable);
+    void TickOrchestrated();
+
+    /*
+     *  State published every tick for the status port.
+     */
+    FStateSnapshot* Snapshot;
+    FStatusServer*  StatusServer;
+
+    void PublishSnapshot();
+
+    /*
+     *  Mounted paks keyed by their normalized pak path.  When
+     *  `pak_budget` is non-zero the resident content of all mounted paks
+     *  is kept under that many bytes by evicting the least recently used
+     *  paks whose content is no longer referenced.
+     */
+    TMap<FString, FMountedPak> MountedPaks;
+    int64                      pak_budget;
+
+    TArray<TWeakObjectPtr<UObject>> ReleasePakContent(FMountedPak& Pak, bool bResetLoaders,
+                                                      TArray<TWeakObjectPtr<UObject>>* Cleared = nullptr);
+    void TouchPak(UObject* Obj);
+    void EnforcePakBudget(const FString& Keep);
+
+    /*
+     *  Background reader that warms the page cache for paks that are
+     *  about to be mounted.
+     */
+    FPakPrefetcher *Prefetcher;
+
+    /*
+     *  Limits the cores and priority of the shader compile workers.
+     */
+    FShaderWorkerControl *ShaderWorkers;
+
+    /*
+     *  In-progress pak uploads keyed by their connection.  While any are
+     *  active the server is polled repeatedly each tick, for up to
+     *  `upload_poll_ms`, so uploads are not throttled by the frame rate.
+     */
+    TMap<struct mg_connection*, TSharedPtr<FPakUpload>> Uploads;
+    int upload_poll_ms;
+
   public:
 
     UFUNCTION()
@@ -65,16 +425,81 @@ class UE4ORCHESTRATOR_API URCHTTP : public UObject, public FTickableGameObject
 
     UFUNCTION()
     int MountPakFile(const FString& PakPath, bool bLoadContent);
+    int MountPakFile(const FString& PakPath, const FPakContentFilter& Filter);
+
+    UFUNCTION()
+    int UnmountPakFile(const FString& PakPath);
+
+    UFUNCTION()
+    bool IsPakMounted(const FString& PakPath) const;
+
+    UFUNCTION()
+    void SetPakBudget(int64 Bytes);
+
+    UFUNCTION()
+    void SetPakCacheLimit(int64 Bytes);
+
+    TSharedRef<FJsonObject> GetMountedPaks() const;
+
+    FPakPrefetcher* GetPrefetcher() const { return Prefetcher; }
+
+    void ReceivePakUpload(struct mg_connection* Conn, http_message_t* Msg);
+    TSharedPtr<FPakUpload> FinishPakUpload(struct mg_connection* Conn);
+    void AbortPakUpload(struct mg_connection* Conn);
 
     /*
      *  TODO: LoadObject should probably be renamed to LoadObjectPak() or
      *        something to that effect.
      */
     UFUNCTION()
-    UObject* LoadObject(const FString& ObjectPath);
+    UObject* LoadObject(const FString& ObjectPath, const FString& ClassName = TEXT(""));
+
+    TSharedRef<FJsonObject> DescribeObject(UObject* Obj);
+
+    UFUNCTION()
+    UClass* ResolveClass(const FString& ClassName);
+
+    /*
+     *  Load a batch of objects with a single async request and return the
+     *  id of the job that tracks it.
+     */
+    int32 LoadObjects(const TArray<FString>& ObjectPaths, const FString& ClassName);
+
+    TSharedRef<FJsonObject> PrefetchObjects(const TArray<FString>& ObjectPaths, double TtlS);
+    TSharedRef<FJsonObject> GetObjectPrefetchStatus() const;
+
+    int32 StartJob(const FString& Kind, TFunction<bool(FOrcJob&)> Update);
+    TSharedPtr<FOrcJob> FindJob(int32 Id) const;
+    TSharedRef<FJsonObject> GetJobStatus(const FOrcJob& Job) const;
+    TSharedRef<FJsonObject> GetJobs() const;
+
+    void DeferReply(struct mg_connection* Conn, double TimeoutS,
+                    TFunction<bool(bool bTimedOut, int& Status, FString& Json)> Poll);
+    void DeferJobReply(struct mg_connection* Conn, int32 JobId, double TimeoutS);
+    void DropDeferredReplies(struct mg_connection* Conn);
+
+    UFUNCTION()
+    int UnloadObject(const FString& ObjectPath, bool bResetLoaders = false);
 
     UFUNCTION()
-    int UnloadObject(const FString& ObjectPath);
+    void RequestGarbageCollect();
+
+    UFUNCTION()
+    void StartIncrementalGarbageCollect(float BudgetMs);
+
+    TSharedRef<FJsonObject> GetGarbageCollectStatus() const;
+    void ConfigureGarbageCollectScheduler(const TSharedPtr<FJsonObject>& Json);
+
+    void NoteRequest()
+    {
+        requests_this_tick++;
+        requests_total++;
+        last_request_time = FPlatformTime::Seconds();
+    }
+
+    bool SetOrchestratedMode(const FString& Mode);
+    TSharedRef<FJsonObject> GetMetrics() const;
+    TSharedRef<FJsonObject> GetStatus() const;
 
     UFUNCTION()
     void GarbageCollect();
@@ -82,6 +507,32 @@ class UE4ORCHESTRATOR_API URCHTTP : public UObject, public FTickableGameObject
     UFUNCTION()
     void FinishAllShaderCompilation();
 
+    bool IsCompilingShaders() const;
+    TSharedRef<FJsonObject> GetShaderCompileStatus() const;
+    int32 WarmPakShaders(const FString& PakPath);
+
+    FShaderWorkerControl* GetShaderWorkers() const { return ShaderWorkers; }
+
+    uint64 BeginFrameFence();
+    bool IsFrameRendered(uint64 Frame);
+
+    bool IsSettled(const FString& Condition) const;
+    void DeferQuiesceReply(struct mg_connection* Conn, const TArray<FString>& Conditions,
+                           int32 Frames, double TimeoutS);
+
+    TArray<TWeakObjectPtr<UTexture2D>> FindTextures(const TArray<FString>& Targets, int32& Unknown) const;
+    TSharedRef<FJsonObject> GetTextureStreamingStatus(const TArray<TWeakObjectPtr<UTexture2D>>& Textures) const;
+    void DeferTextureReply(struct mg_connection* Conn,
+                           const TArray<TWeakObjectPtr<UTexture2D>>& Textures, double TimeoutS);
+
+    void SetThroughputMode(bool bEnable);
+    TSharedRef<FJsonObject> GetThroughputMode() const;
+
+    int  StartStep(int32 Frames, float DeltaSeconds, bool bRender);
+    bool IsStepping() const { return step.Pending > 0; }
+    void ReleaseStepMode();
+    TSharedRef<FJsonObject> GetStepStatus() const;
+
     /*
      * Frame End
      */
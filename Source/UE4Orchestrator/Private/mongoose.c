@@ -3267,7 +3267,9 @@ struct mg_iface *mg_find_iface(struct mg_mgr *mgr,
 /* Amalgamated: #include "mg_internal.h" */
 /* Amalgamated: #include "mg_util.h" */
 
+#ifndef MG_TCP_RECV_BUFFER_SIZE
 #define MG_TCP_RECV_BUFFER_SIZE 1024
+#endif
 #define MG_UDP_RECV_BUFFER_SIZE 1500
 
 static sock_t mg_open_listening_socket(union socket_address *sa, int type,
@@ -13744,7 +13746,9 @@ extern const struct mg_iface_vtable mg_simplelink_iface_vtable;
 /* Amalgamated: #include "mongoose/src/internal.h" */
 /* Amalgamated: #include "mongoose/src/util.h" */
 
+#ifndef MG_TCP_RECV_BUFFER_SIZE
 #define MG_TCP_RECV_BUFFER_SIZE 1024
+#endif
 #define MG_UDP_RECV_BUFFER_SIZE 1500
 
 static sock_t mg_open_listening_socket(struct mg_connection *nc,
@@ -16,6 +16,9 @@ DECLARE_LOG_CATEGORY_EXTERN(LogUE4Orc, Log, All);
 #include "Runtime/Core/Public/HAL/FileManagerGeneric.h"
 #include "StreamingNetworkPlatformFile.h"
 #include "Runtime/AssetRegistry/Public/AssetRegistryModule.h"
+#include "Runtime/Engine/Classes/Engine/StreamableManager.h"
+#include "Dom/JsonObject.h"
+#include "Misc/SecureHash.h"
 #include "Modules/ModuleInterface.h"
 
 #if WITH_EDITOR
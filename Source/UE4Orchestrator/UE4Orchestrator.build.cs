@@ -58,6 +58,9 @@ public class UE4Orchestrator : ModuleRules
             }
             );
 
+        // Read pak uploads in 64KB pieces rather than mongoose's default 1KB.
+        Definitions.Add("MG_TCP_RECV_BUFFER_SIZE=65536");
+
         if (Target.bBuildEditor)
         {
             PrivateDependencyModuleNames.Add("UnrealEd");